@@ -112,6 +112,13 @@ public:
      *  (e.g. screwdriver/tip, kettle/spout, mug/base).
      */
     moveit::core::FixedTransformsMap subframe_poses_;
+
+    /** \brief A small integer identifying the object in the world it was added to, assigned when it is created.
+     *  Indices of removed objects are reused, so all indices stay below World::getObjectIndexBound() and collision
+     *  backends can keep per-object data in arrays instead of looking it up by id. An index is only unique among the
+     *  current objects: observers have to drop the data of an index when they are notified about the DESTROY of its
+     *  object, which is always delivered before a new object with that index is reported. */
+    std::size_t index_ = 0;
   };
 
   /** \brief Get the list of Object ids */
@@ -143,6 +150,12 @@ public:
     return objects_.find(id);
   }
 
+  /** \brief All object indices (Object::index_) are smaller than this bound */
+  std::size_t getObjectIndexBound() const
+  {
+    return index_bound_;
+  }
+
   /** \brief Check if a particular object exists in the collision world*/
   bool hasObject(const std::string& object_id) const;
 
@@ -269,6 +282,32 @@ public:
    * Used which switching from one world to another. */
   void notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const;
 
+  /** \brief Start collecting changes instead of notifying observers right away.
+   * Calls may be nested; observers are notified when the outermost batch is finished. */
+  void startBatch();
+
+  /** \brief Finish a batch started with startBatch(). When the outermost batch finishes, each observer is
+   * notified once for every object that changed during the batch, with the actions that happened to it combined.
+   * Objects that were created and destroyed within the batch are not reported. */
+  void finishBatch();
+
+  /** \brief Collects the changes made to a world while it exists and notifies the observers when it is destroyed */
+  class Batch
+  {
+  public:
+    explicit Batch(World& world) : world_(world)
+    {
+      world_.startBatch();
+    }
+    ~Batch()
+    {
+      world_.finishBatch();
+    }
+
+  private:
+    World& world_;
+  };
+
 private:
   /** notify all observers of a change */
   void notify(const ObjectConstPtr&, Action);
@@ -276,6 +315,23 @@ private:
   /** send notification of change to all objects. */
   void notifyAll(Action action);
 
+  /** \brief Create a new object named \e id, with the lowest unused index */
+  ObjectPtr createObject(const std::string& id);
+
+  /** \brief Remove an object from objects_ and make its index available again */
+  void eraseObject(std::map<std::string, ObjectPtr>::iterator it);
+
+  /** \brief Make \e index available for new objects, or, during a batch, once the outermost batch is finished */
+  void releaseIndex(std::size_t index);
+
+  /** \brief Find the object a subframe \e name ("object name/subframe name") belongs to. Object names may contain
+   * slashes themselves, so every prefix of \e name that ends before a slash is tried, shortest first.
+   * If \e first_only is true, the search stops at the first object found, even if it does not have the subframe */
+  const Eigen::Isometry3d* findSubframe(const std::string& name, bool first_only) const;
+
+  /** \brief Record a change made during a batch */
+  void addPendingChange(const ObjectConstPtr& obj, Action action);
+
   /** \brief Make sure that the object named \e id is known only to this
    * instance of the World. If the object is known outside of it, a
    * clone is made so that it can be safely modified later on. */
@@ -298,6 +354,32 @@ private:
     ObserverCallbackFn callback_;
   };
   std::vector<Observer*> observers_;
+
+  /** \brief A change collected during a batch */
+  struct PendingChange
+  {
+    /** \brief The object that existed before the batch, if it was destroyed during the batch */
+    ObjectConstPtr destroyed_;
+
+    /** \brief The combined actions on the object that exists now */
+    int action_ = UNINITIALIZED;
+  };
+
+  /** \brief One more than the highest index assigned to an object */
+  std::size_t index_bound_;
+
+  /** \brief Indices below index_bound_ that are not used by any object */
+  std::vector<std::size_t> free_indices_;
+
+  /** \brief Indices of objects removed during the current batch. They are only reused after the batch is finished, so
+   *  observers never see an object created with an index before the removal of the object that had it before */
+  std::vector<std::size_t> released_indices_;
+
+  /** \brief The nesting depth of batches; changes are collected while this is not 0 */
+  unsigned int batch_depth_;
+
+  /** \brief The changes collected in the current batch */
+  std::map<std::string, PendingChange> pending_changes_;
 };
 }
 
@@ -35,18 +35,23 @@
 /* Author: Acorn Pooley, Ioan Sucan */
 
 #include <moveit/collision_detection/world.h>
-#include <boost/algorithm/string/predicate.hpp>
 #include <ros/console.h>
+#include <algorithm>
+#include <functional>
 
 namespace collision_detection
 {
-World::World()
+World::World() : index_bound_(0), batch_depth_(0)
 {
 }
 
 World::World(const World& other)
+  : index_bound_(other.index_bound_), free_indices_(other.free_indices_), batch_depth_(0)
 {
   objects_ = other.objects_;
+  // the copy has no observers that still need to learn about removals in a batch of other
+  for (std::size_t index : other.released_indices_)
+    releaseIndex(index);
 }
 
 World::~World()
@@ -80,7 +85,7 @@ void World::addToObject(const std::string& id, const std::vector<shapes::ShapeCo
   ObjectPtr& obj = objects_[id];
   if (!obj)
   {
-    obj.reset(new Object(id));
+    obj = createObject(id);
     action |= CREATE;
   }
 
@@ -99,7 +104,7 @@ void World::addToObject(const std::string& id, const shapes::ShapeConstPtr& shap
   ObjectPtr& obj = objects_[id];
   if (!obj)
   {
-    obj.reset(new Object(id));
+    obj = createObject(id);
     action |= CREATE;
   }
 
@@ -126,6 +131,38 @@ World::ObjectConstPtr World::getObject(const std::string& object_id) const
     return it->second;
 }
 
+World::ObjectPtr World::createObject(const std::string& id)
+{
+  ObjectPtr obj(new Object(id));
+  if (free_indices_.empty())
+    obj->index_ = index_bound_++;
+  else
+  {
+    // hand out the lowest free index, so indices stay dense
+    std::pop_heap(free_indices_.begin(), free_indices_.end(), std::greater<std::size_t>());
+    obj->index_ = free_indices_.back();
+    free_indices_.pop_back();
+  }
+  return obj;
+}
+
+void World::eraseObject(std::map<std::string, ObjectPtr>::iterator it)
+{
+  releaseIndex(it->second->index_);
+  objects_.erase(it);
+}
+
+void World::releaseIndex(std::size_t index)
+{
+  if (batch_depth_ > 0)
+  {
+    released_indices_.push_back(index);
+    return;
+  }
+  free_indices_.push_back(index);
+  std::push_heap(free_indices_.begin(), free_indices_.end(), std::greater<std::size_t>());
+}
+
 void World::ensureUnique(ObjectPtr& obj)
 {
   if (obj && !obj.unique())
@@ -145,16 +182,24 @@ bool World::knowsTransform(const std::string& name) const
     // only accept object name as frame if it is associated to a unique shape
     return it->second->shape_poses_.size() == 1;
   else  // Then objects' subframes
+    return findSubframe(name, true) != nullptr;
+}
+
+const Eigen::Isometry3d* World::findSubframe(const std::string& name, bool first_only) const
+{
+  // objects are looked up by every prefix of name that is followed by a slash, instead of comparing name to all objects
+  for (std::size_t slash = name.find('/'); slash != std::string::npos; slash = name.find('/', slash + 1))
   {
-    for (const std::pair<std::string, ObjectPtr>& object : objects_)
-    {
-      // if "object name/" matches start of object_id, we found the matching object
-      if (boost::starts_with(name, object.first) && name[object.first.length()] == '/')
-        return object.second->subframe_poses_.find(name.substr(object.first.length() + 1)) !=
-               object.second->subframe_poses_.end();
-    }
+    auto it = objects_.find(name.substr(0, slash));
+    if (it == objects_.end())
+      continue;
+    auto jt = it->second->subframe_poses_.find(name.substr(slash + 1));
+    if (jt != it->second->subframe_poses_.end())
+      return &jt->second;
+    if (first_only)
+      break;
   }
-  return false;
+  return nullptr;
 }
 
 const Eigen::Isometry3d& World::getTransform(const std::string& name) const
@@ -173,18 +218,11 @@ const Eigen::Isometry3d& World::getTransform(const std::string& name, bool& fram
     return it->second->shape_poses_[0];
   else  // Search within subframes
   {
-    for (const std::pair<std::string, ObjectPtr>& object : objects_)
+    const Eigen::Isometry3d* subframe = findSubframe(name, false);
+    if (subframe)
     {
-      // if "object name/" matches start of object_id, we found the matching object
-      if (boost::starts_with(name, object.first) && name[object.first.length()] == '/')
-      {
-        auto it = object.second->subframe_poses_.find(name.substr(object.first.length() + 1));
-        if (it != object.second->subframe_poses_.end())
-        {
-          frame_found = true;
-          return it->second;
-        }
-      }
+      frame_found = true;
+      return *subframe;
     }
   }
 
@@ -245,7 +283,7 @@ bool World::removeShapeFromObject(const std::string& object_id, const shapes::Sh
         if (it->second->shapes_.empty())
         {
           notify(it->second, DESTROY);
-          objects_.erase(it);
+          eraseObject(it);
         }
         else
         {
@@ -263,7 +301,7 @@ bool World::removeObject(const std::string& object_id)
   if (it != objects_.end())
   {
     notify(it->second, DESTROY);
-    objects_.erase(it);
+    eraseObject(it);
     return true;
   }
   return false;
@@ -272,7 +310,16 @@ bool World::removeObject(const std::string& object_id)
 void World::clearObjects()
 {
   notifyAll(DESTROY);
+  if (batch_depth_ > 0)
+  {
+    for (const std::pair<const std::string, ObjectPtr>& object : objects_)
+      releaseIndex(object.second->index_);
+    objects_.clear();
+    return;
+  }
   objects_.clear();
+  index_bound_ = 0;
+  free_indices_.clear();
 }
 
 bool World::setSubframesOfObject(const std::string& object_id, const moveit::core::FixedTransformsMap& subframe_poses)
@@ -314,10 +361,63 @@ void World::notifyAll(Action action)
 
 void World::notify(const ObjectConstPtr& obj, Action action)
 {
+  if (batch_depth_ > 0)
+  {
+    addPendingChange(obj, action);
+    return;
+  }
   for (std::vector<Observer*>::const_iterator obs = observers_.begin(); obs != observers_.end(); ++obs)
     (*obs)->callback_(obj, action);
 }
 
+void World::addPendingChange(const ObjectConstPtr& obj, Action action)
+{
+  PendingChange& change = pending_changes_[obj->id_];
+  if (action == DESTROY)
+  {
+    // an object created within the batch was never seen by the observers
+    if (!change.destroyed_ && !(change.action_ & CREATE))
+      change.destroyed_ = obj;
+    change.action_ = UNINITIALIZED;
+    if (!change.destroyed_)
+      pending_changes_.erase(obj->id_);
+  }
+  else
+    change.action_ |= action;
+}
+
+void World::startBatch()
+{
+  ++batch_depth_;
+}
+
+void World::finishBatch()
+{
+  if (batch_depth_ == 0 || --batch_depth_ > 0)
+    return;
+
+  std::map<std::string, PendingChange> changes;
+  changes.swap(pending_changes_);
+  for (auto obs : observers_)
+    for (const std::pair<const std::string, PendingChange>& change : changes)
+    {
+      if (change.second.destroyed_)
+        obs->callback_(change.second.destroyed_, DESTROY);
+      if (change.second.action_ != UNINITIALIZED)
+      {
+        auto it = objects_.find(change.first);
+        if (it != objects_.end())
+          obs->callback_(it->second, change.second.action_);
+      }
+    }
+
+  // the removals were delivered, so the indices of the removed objects can be reused
+  std::vector<std::size_t> released;
+  released.swap(released_indices_);
+  for (std::size_t index : released)
+    releaseIndex(index);
+}
+
 void World::notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const
 {
   for (auto observer : observers_)
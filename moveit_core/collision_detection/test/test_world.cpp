@@ -365,6 +365,184 @@ TEST(World, TrackChanges)
   EXPECT_EQ(4, ta3.cnt_);
 }
 
+/* notification callback recording every action in order */
+static void RecordChangesNotify(std::vector<std::pair<std::string, int> >* changes,
+                                const collision_detection::World::ObjectConstPtr& obj,
+                                collision_detection::World::Action action)
+{
+  changes->push_back(std::make_pair(obj->id_, static_cast<int>(action)));
+}
+
+TEST(World, BatchChanges)
+{
+  collision_detection::World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  shapes::ShapePtr box(new shapes::Box(1, 2, 3));
+  world.addToObject("existing", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("replaced", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("removed", ball, Eigen::Isometry3d::Identity());
+
+  std::vector<std::pair<std::string, int> > changes;
+  world.addObserver(boost::bind(RecordChangesNotify, &changes, _1, _2));
+
+  {
+    collision_detection::World::Batch batch(world);
+    world.moveShapeInObject("existing", ball, Eigen::Isometry3d(Eigen::Translation3d(0, 0, 1)));
+    world.addToObject("existing", box, Eigen::Isometry3d::Identity());
+    world.moveObject("existing", Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0)));
+
+    world.removeObject("replaced");
+    world.addToObject("replaced", box, Eigen::Isometry3d::Identity());
+
+    world.moveObject("removed", Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0)));
+    world.removeObject("removed");
+
+    world.addToObject("temporary", box, Eigen::Isometry3d::Identity());
+    world.removeObject("temporary");
+
+    {
+      // nested batches are delivered with the outermost one
+      collision_detection::World::Batch nested(world);
+      world.addToObject("new", box, Eigen::Isometry3d::Identity());
+    }
+    EXPECT_TRUE(changes.empty());
+  }
+
+  // one notification per object with the combined actions, in order of the object ids
+  ASSERT_EQ(5u, changes.size());
+  EXPECT_EQ("existing", changes[0].first);
+  EXPECT_EQ(collision_detection::World::MOVE_SHAPE | collision_detection::World::ADD_SHAPE, changes[0].second);
+  EXPECT_EQ("new", changes[1].first);
+  EXPECT_EQ(collision_detection::World::CREATE | collision_detection::World::ADD_SHAPE, changes[1].second);
+  EXPECT_EQ("removed", changes[2].first);
+  EXPECT_EQ(collision_detection::World::DESTROY, changes[2].second);
+  EXPECT_EQ("replaced", changes[3].first);
+  EXPECT_EQ(collision_detection::World::DESTROY, changes[3].second);
+  EXPECT_EQ("replaced", changes[4].first);
+  EXPECT_EQ(collision_detection::World::CREATE | collision_detection::World::ADD_SHAPE, changes[4].second);
+
+  // outside of batches, observers are notified right away
+  changes.clear();
+  world.removeObject("new");
+  ASSERT_EQ(1u, changes.size());
+  EXPECT_EQ(collision_detection::World::DESTROY, changes[0].second);
+}
+
+TEST(World, ObjectIndices)
+{
+  collision_detection::World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  world.addToObject("a", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("b", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("c", ball, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(0u, world.getObject("a")->index_);
+  EXPECT_EQ(1u, world.getObject("b")->index_);
+  EXPECT_EQ(2u, world.getObject("c")->index_);
+  EXPECT_EQ(3u, world.getObjectIndexBound());
+
+  // indices of removed objects are reused, lowest first
+  world.removeObject("c");
+  world.removeObject("a");
+  world.addToObject("d", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("e", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("f", ball, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(0u, world.getObject("d")->index_);
+  EXPECT_EQ(2u, world.getObject("e")->index_);
+  EXPECT_EQ(3u, world.getObject("f")->index_);
+  EXPECT_EQ(4u, world.getObjectIndexBound());
+
+  // modifying an object keeps its index, also in copies
+  collision_detection::World copy(world);
+  copy.moveObject("b", Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0)));
+  EXPECT_EQ(1u, copy.getObject("b")->index_);
+  copy.addToObject("g", ball, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(4u, copy.getObject("g")->index_);
+
+  world.clearObjects();
+  EXPECT_EQ(0u, world.getObjectIndexBound());
+}
+
+/* notification callback that keeps track of the objects by their index */
+static void TrackIndicesNotify(std::vector<std::string>* ids, const collision_detection::World::ObjectConstPtr& obj,
+                               collision_detection::World::Action action)
+{
+  if (ids->size() <= obj->index_)
+    ids->resize(obj->index_ + 1);
+  std::string& id = (*ids)[obj->index_];
+  if (action & collision_detection::World::DESTROY)
+  {
+    EXPECT_EQ(obj->id_, id);
+    id.clear();
+  }
+  else if (action & collision_detection::World::CREATE)
+  {
+    EXPECT_TRUE(id.empty()) << obj->id_ << " was created with the index of " << id;
+    id = obj->id_;
+  }
+}
+
+TEST(World, BatchIndexReuse)
+{
+  collision_detection::World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  std::vector<std::string> ids;
+  world.addObserver(boost::bind(TrackIndicesNotify, &ids, _1, _2));
+  world.addToObject("z", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("y", ball, Eigen::Isometry3d::Identity());
+
+  {
+    // "a" is delivered before "z", so it must not get the index of "z" during the batch
+    collision_detection::World::Batch batch(world);
+    world.removeObject("z");
+    {
+      collision_detection::World::Batch nested(world);
+      world.addToObject("a", ball, Eigen::Isometry3d::Identity());
+    }
+    EXPECT_EQ(2u, world.getObject("a")->index_);
+  }
+  EXPECT_EQ(std::vector<std::string>({ "", "y", "a" }), ids);
+
+  // after the batch, the index of "z" is reused
+  world.addToObject("b", ball, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(0u, world.getObject("b")->index_);
+
+  {
+    collision_detection::World::Batch batch(world);
+    world.clearObjects();
+    world.addToObject("c", ball, Eigen::Isometry3d::Identity());
+    EXPECT_EQ(3u, world.getObject("c")->index_);
+  }
+  EXPECT_EQ(std::vector<std::string>({ "", "", "", "c" }), ids);
+  world.addToObject("d", ball, Eigen::Isometry3d::Identity());
+  EXPECT_EQ(0u, world.getObject("d")->index_);
+}
+
+TEST(World, SubframeLookup)
+{
+  collision_detection::World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  world.addToObject("tool", ball, Eigen::Isometry3d::Identity());
+  world.addToObject("tool/holder", ball, Eigen::Isometry3d::Identity());
+  moveit::core::FixedTransformsMap subframes;
+  subframes["holder/tip"] = Eigen::Isometry3d(Eigen::Translation3d(1, 0, 0));
+  world.setSubframesOfObject("tool", subframes);
+  subframes.clear();
+  subframes["grip"] = Eigen::Isometry3d(Eigen::Translation3d(2, 0, 0));
+  world.setSubframesOfObject("tool/holder", subframes);
+
+  EXPECT_TRUE(world.knowsTransform("tool/holder/tip"));
+  EXPECT_FALSE(world.knowsTransform("tool/missing"));
+  EXPECT_FALSE(world.knowsTransform("other/grip"));
+
+  bool found = false;
+  EXPECT_EQ(1.0, world.getTransform("tool/holder/tip", found).translation().x());
+  EXPECT_TRUE(found);
+  EXPECT_EQ(2.0, world.getTransform("tool/holder/grip", found).translation().x());
+  EXPECT_TRUE(found);
+  world.getTransform("tool/holder/missing", found);
+  EXPECT_FALSE(found);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
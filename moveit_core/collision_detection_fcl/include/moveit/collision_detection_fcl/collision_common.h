@@ -158,10 +158,14 @@ struct CollisionData
   bool done_;
 };
 
+class LinkPairDistanceBounds;
+
 struct DistanceData
 {
-  DistanceData(const DistanceRequest* req, DistanceResult* res) : req(req), res(res), done(false)
+  DistanceData(const DistanceRequest* req, DistanceResult* res)
+    : req(req), res(res), done(false), link_pair_bounds(nullptr)
   {
+    closest_objects[0] = closest_objects[1] = nullptr;
   }
   ~DistanceData()
   {
@@ -175,6 +179,12 @@ struct DistanceData
 
   /// Indicates if distance query is finished.
   bool done;
+
+  /// The collision objects of the closest pair found so far, in the order they were passed to distanceCallback
+  fcl::CollisionObjectd* closest_objects[2];
+
+  /// If set, lower bounds on the distances of robot link pairs, used to skip pairs and updated with new distances
+  LinkPairDistanceBounds* link_pair_bounds;
 };
 
 MOVEIT_STRUCT_FORWARD(FCLGeometry);
@@ -236,10 +246,38 @@ struct FCLManager
   std::shared_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
 };
 
+/** \brief The closest pair of collision objects found by a GLOBAL distance query. A query for a similar state can
+    evaluate this pair first, so that its distance bounds the search over all other pairs */
+struct DistanceQueryHint
+{
+  DistanceQueryHint() : valid(false)
+  {
+  }
+
+  /** \brief Remember \e co, which has to be part of \e fcl_obj, as element \e side of the closest pair */
+  bool setObject(std::size_t side, const fcl::CollisionObjectd* co, const FCLObject& fcl_obj);
+
+  /** \brief Get the collision object of \e fcl_obj that corresponds to element \e side of the closest pair, or
+      nullptr if \e fcl_obj does not contain it anymore */
+  fcl::CollisionObjectd* getObject(std::size_t side, const FCLObject& fcl_obj) const;
+
+  bool valid;
+  BodyType types[2];
+  std::string ids[2];
+  const void* raw[2];
+  int shape_indices[2];
+  std::size_t indices[2];
+};
+
 bool collisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data);
 
 bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist);
 
+/** \brief Make distanceCallback() compute the penetration depth of all pairs from collision contacts, as it does for
+    pairs involving non-convex geometry, instead of by the distance query of two convex shapes. This affects all
+    signed distance queries of the process and is only meant for benchmarks. */
+void setSignedDistanceFromContacts(bool enable);
+
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, const robot_model::LinkModel* link,
                                             int shape_index);
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, const robot_state::AttachedBody* ab,
@@ -38,6 +38,8 @@
 #define MOVEIT_COLLISION_DETECTION_FCL_COLLISION_ROBOT_
 
 #include <moveit/collision_detection_fcl/collision_common.h>
+#include <moveit/collision_detection_fcl/link_pair_distance_bounds.h>
+#include <boost/thread/mutex.hpp>
 
 namespace collision_detection
 {
@@ -83,9 +85,22 @@ public:
 protected:
   void updatedPaddingOrScaling(const std::vector<std::string>& links) override;
   void constructFCLObject(const robot_state::RobotState& state, FCLObject& fcl_obj) const;
+
+  /** \brief Compute a box (in the model frame) that contains the bounding boxes of all FCL objects
+      constructFCLObject() creates for \e state, without creating them */
+  void computeAABB(const robot_state::RobotState& state, Eigen::AlignedBox3d& aabb) const;
   void allocSelfCollisionBroadPhase(const robot_state::RobotState& state, FCLManager& manager) const;
   void getAttachedBodyObjects(const robot_state::AttachedBody* ab, std::vector<FCLGeometryConstPtr>& geoms) const;
 
+  /** \brief Get the collision geometry of \e ab together with untransformed FCL objects for it. The objects are cached
+      per shape, so bodies sharing their shapes (e.g. in copies of a RobotState) reuse them and collision checks only
+      need to transform them */
+  void getAttachedBodyObjects(const robot_state::AttachedBody* ab, std::vector<FCLGeometryConstPtr>& geoms,
+                              std::vector<FCLCollisionObjectConstPtr>& objs) const;
+
+  /** \brief Set up distance_bounds_ for the current geometry of the links */
+  void initDistanceBounds();
+
   void checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res, const robot_state::RobotState& state,
                                 const AllowedCollisionMatrix* acm) const;
   void checkOtherCollisionHelper(const CollisionRequest& req, CollisionResult& res,
@@ -94,6 +109,14 @@ protected:
 
   std::vector<FCLGeometryConstPtr> geoms_;
   std::vector<FCLCollisionObjectConstPtr> fcl_objs_;
+
+  /** \brief The closest pair of the last GLOBAL distanceSelf() query, evaluated first by the next one */
+  mutable DistanceQueryHint distance_hint_;
+  mutable boost::mutex distance_hint_lock_;
+
+  /** \brief Link pair distances of the last distanceSelf() query, taken over by the next one (guarded by
+      distance_hint_lock_) */
+  mutable LinkPairDistanceBounds distance_bounds_;
 };
 }
 
@@ -39,6 +39,7 @@
 
 #include <moveit/collision_detection_fcl/collision_robot_fcl.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <moveit/collision_detection_fcl/octree_occupancy_index.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_collision_manager.h>
@@ -47,6 +48,9 @@
 #endif
 
 #include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace collision_detection
 {
@@ -86,10 +90,66 @@ protected:
                                  const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const;
 
   void constructFCLObject(const World::Object* obj, FCLObject& fcl_obj) const;
-  void updateFCLObject(const std::string& id);
+  void updateFCLObject(const World::Object* obj);
 
-  std::unique_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
-  std::map<std::string, FCLObject> fcl_objs_;
+  /** \brief Get the FCL objects of the world object with index \e index, adding an empty entry if needed */
+  FCLObject& getFCLObject(std::size_t index);
+
+  /** \brief Get the FCL objects of the world object with index \e index, or nullptr if there are none */
+  const FCLObject* findFCLObject(std::size_t index) const;
+
+  /** \brief Update the FCL objects of \e obj after its shapes were moved, keeping their geometry.
+      Returns false if the FCL objects do not match the shapes of \e obj and have to be reconstructed instead */
+  bool updateFCLObjectTransforms(const World::Object* obj);
+
+  /** \brief Index the occupied leaves of the octomaps among the shapes of \e obj, whose FCL objects are \e fcl_obj */
+  void indexOctrees(const World::Object* obj, const FCLObject& fcl_obj);
+
+  /** \brief Return false if no object of this world can touch the axis-aligned box \e aabb, determined by a
+      broadphase query only. If \e use_octree_index is set, octomaps only count if the box contains occupied leaves */
+  bool mayOverlap(const Eigen::AlignedBox3d& aabb, bool use_octree_index) const;
+
+  /** \brief Remove the FCL objects of the world object with index \e index from the broadphase structure used by
+      this world */
+  void unregisterFCLObject(std::size_t index, FCLObject& fcl_obj);
+
+  /** \brief Add the FCL objects of the world object with index \e index to the broadphase structure owned by this
+      world */
+  void registerFCLObject(std::size_t index, FCLObject& fcl_obj);
+
+  /** \brief Called before the broadphase structures are modified. If copies of this world use manager_ as their
+      shared broadphase structure, it is left untouched and this world starts using it as shared structure as well */
+  void unshareManager();
+
+  /** \brief Rebuild manager_ from all FCL objects of this world and stop using a shared broadphase structure */
+  void rebuildManager();
+
+  /** \brief Broadphase structure for the FCL objects of this world. If shared_manager_ is set, it only contains the
+      objects that changed since the shared structure was taken over */
+  std::shared_ptr<fcl::BroadPhaseCollisionManagerd> manager_;
+
+  /** \brief Broadphase structure shared (read-only) with the world this one was copied from, if any */
+  std::shared_ptr<fcl::BroadPhaseCollisionManagerd> shared_manager_;
+
+  /** \brief Collision objects in shared_manager_ that were changed or removed in this world and have to be ignored.
+      The pointers are kept so the objects outlive the shared structure that still references them */
+  std::unordered_map<const fcl::CollisionObjectd*, FCLCollisionObjectPtr> hidden_shared_objs_;
+
+  /** \brief The indices of the world objects whose FCL objects are registered to manager_ while shared_manager_ is
+      used */
+  std::set<std::size_t> unshared_objs_;
+
+  /** \brief The FCL objects of the world objects, indexed by World::Object::index_. The entry of an object is cleared
+      when it is destroyed, before its index can be given to a new object */
+  std::vector<FCLObject> fcl_objs_;
+
+  /** \brief Occupancy indices of the collision objects of octomaps, which are kept alive along with their index */
+  std::unordered_map<const fcl::CollisionObjectd*, std::pair<FCLCollisionObjectPtr, OctreeOccupancyIndexConstPtr> >
+      octree_occupancy_;
+
+  /** \brief The closest pair of the last GLOBAL distanceRobot() query, evaluated first by the next one */
+  mutable DistanceQueryHint distance_hint_;
+  mutable boost::mutex distance_hint_lock_;
 
 private:
   void initialize();
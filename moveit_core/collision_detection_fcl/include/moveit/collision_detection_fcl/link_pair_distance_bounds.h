@@ -0,0 +1,107 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_COLLISION_DETECTION_FCL_LINK_PAIR_DISTANCE_BOUNDS_
+#define MOVEIT_COLLISION_DETECTION_FCL_LINK_PAIR_DISTANCE_BOUNDS_
+
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace collision_detection
+{
+/** \brief Lower bounds on the distances between the collision bodies of a robot's links, carried from one distance
+    query to the next.
+
+    A distance computed for a pair of bodies stays a valid lower bound in later states once it is decreased by how far
+    the bodies can have moved relative to each other. That motion is bounded by the changes of the joints between the
+    two bodies, each multiplied by the largest distance of the body from the joint's axis over all configurations
+    (precomputed from the link lengths and the size of the body). Self-distance queries from similar states, as in
+    servoing, can skip the narrowphase for pairs whose bound exceeds the distance of interest without changing the
+    result. */
+class LinkPairDistanceBounds
+{
+public:
+  LinkPairDistanceBounds();
+
+  /** \brief Precompute the motion bounds of the collision bodies of \e model. \e body_reach holds, for every body
+      (indexed like RobotState::getCollisionBodyTransform()), the distance from its link's origin to its farthest
+      point, or infinity for bodies without geometry */
+  LinkPairDistanceBounds(const robot_model::RobotModelConstPtr& model, const std::vector<double>& body_reach);
+
+  /** \brief Start a query for \e state. The bounds recorded since the previous call remain available, decreased by
+      the motion of the bodies between the two states */
+  void update(const robot_state::RobotState& state);
+
+  /** \brief Whether the bounds were set up for a robot model */
+  bool isInitialized() const
+  {
+    return chains_ != nullptr;
+  }
+
+  /** \brief Forget all recorded bounds, e.g. because the geometry of the bodies changed */
+  void clear();
+
+  /** \brief A lower bound on the current distance between two bodies; minus infinity if none is known */
+  double getLowerBound(std::size_t body1, std::size_t body2) const;
+
+  /** \brief Record a lower bound on the current distance between two bodies */
+  void setLowerBound(std::size_t body1, std::size_t body2, double distance);
+
+private:
+  /** \brief For every body, its movable ancestor joints from the body up to the root, each with the largest distance
+      of the body from the joint's axis (or the factor 1 for prismatic joints) */
+  typedef std::vector<std::vector<std::pair<int, double> > > BodyChains;
+
+  /** \brief How far two bodies can have moved relative to each other since the previous state */
+  double getRelativeMotion(std::size_t body1, std::size_t body2) const;
+
+  std::shared_ptr<const BodyChains> chains_;
+  std::size_t body_count_;
+
+  /** \brief The variable positions of the previous state; empty if there was none */
+  std::vector<double> previous_positions_;
+
+  /** \brief The largest change of a variable of each joint since the previous state */
+  std::vector<double> joint_motion_;
+
+  /** \brief Lower bounds for all pairs of bodies (row-major, first index smaller) in the previous and current state */
+  std::vector<double> previous_bounds_;
+  std::vector<double> bounds_;
+};
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_COLLISION_DETECTION_FCL_OCTREE_OCCUPANCY_INDEX_
+#define MOVEIT_COLLISION_DETECTION_FCL_OCTREE_OCCUPANCY_INDEX_
+
+#include <moveit/macros/class_forward.h>
+#include <octomap/OcTree.h>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <unordered_set>
+
+namespace collision_detection
+{
+MOVEIT_CLASS_FORWARD(OctreeOccupancyIndex);
+
+/** \brief A hash of the coarse grid cells that contain occupied leaves of an octree.
+
+    Built once when an octomap is added to a world, it lets collision checks rule out objects whose bounding box
+    contains no occupied leaf with a few hash lookups, instead of traversing the octree. */
+class OctreeOccupancyIndex
+{
+public:
+  /** \brief Index the occupied leaves of \e octree, placed in the world at \e pose */
+  OctreeOccupancyIndex(const octomap::OcTree& octree, const Eigen::Isometry3d& pose);
+
+  /** \brief Return false if the axis-aligned box from \e min to \e max (in world coordinates) certainly does not
+      intersect any occupied leaf. Returns true if it may, or if the box covers too many cells to tell quickly */
+  bool mayBeOccupied(const Eigen::Vector3d& min, const Eigen::Vector3d& max) const;
+
+  /** \brief The edge length of the grid cells */
+  double getCellSize() const
+  {
+    return cell_size_;
+  }
+
+  /** \brief The number of grid cells that contain occupied leaves */
+  std::size_t getOccupiedCellCount() const
+  {
+    return cells_.size();
+  }
+
+private:
+  /** \brief Pack the integer coordinates of a cell into a hash key */
+  static std::uint64_t cellKey(std::int64_t x, std::int64_t y, std::int64_t z);
+
+  double cell_size_;
+  std::unordered_set<std::uint64_t> cells_;
+};
+}
+
+#endif
@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan, Jia Pan */
 
 #include <moveit/collision_detection_fcl/collision_common.h>
+#include <moveit/collision_detection_fcl/link_pair_distance_bounds.h>
 #include <geometric_shapes/shapes.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
 
@@ -48,6 +49,8 @@
 #endif
 
 #include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <limits>
 #include <memory>
 
 namespace collision_detection
@@ -394,6 +397,38 @@ struct FCLShapeCache
   unsigned int clean_count_;
 };
 
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+/** \brief Whether fcl::distance() can compute the penetration depth for this geometry (via EPA), which it does for
+ *  convex shapes only */
+static bool supportsSignedDistance(const fcl::CollisionGeometryd& geom)
+{
+  switch (geom.getNodeType())
+  {
+    case fcl::GEOM_BOX:
+    case fcl::GEOM_SPHERE:
+    case fcl::GEOM_ELLIPSOID:
+    case fcl::GEOM_CAPSULE:
+    case fcl::GEOM_CONE:
+    case fcl::GEOM_CYLINDER:
+    case fcl::GEOM_CONVEX:
+      return true;
+    default:
+      return false;
+  }
+}
+#endif
+
+/** \brief Maximum number of contacts computed to find the penetration depth of pairs involving non-convex geometry */
+static const std::size_t MAX_PENETRATION_CONTACTS = 200;
+
+/** \brief Set by setSignedDistanceFromContacts() */
+static std::atomic<bool> signed_distance_from_contacts(false);
+
+void setSignedDistanceFromContacts(bool enable)
+{
+  signed_distance_from_contacts = enable;
+}
+
 bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist)
 {
   DistanceData* cdata = reinterpret_cast<DistanceData*>(data);
@@ -513,8 +548,43 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
     }
   }
 
-  fcl_result.min_distance = dist_threshold;
-  double d = fcl::distance(o1, o2, fcl::DistanceRequestd(cdata->req->enable_nearest_points), fcl_result);
+  // a global query only has to find pairs closer than the closest one found so far; colliding pairs are always
+  // evaluated, as their penetration depth may still be needed
+  if (cdata->req->type == DistanceRequestType::GLOBAL && cdata->res->minimum_distance.distance > 0 &&
+      cdata->res->minimum_distance.distance < dist_threshold)
+    dist_threshold = cdata->res->minimum_distance.distance;
+
+  // robot link pairs that cannot have come closer than the threshold since they were last evaluated are skipped
+  const bool link_pair = cdata->link_pair_bounds && cd1->type == BodyTypes::ROBOT_LINK &&
+                         cd2->type == BodyTypes::ROBOT_LINK;
+  std::size_t body1 = 0, body2 = 0;
+  double d = -std::numeric_limits<double>::infinity();
+  if (link_pair)
+  {
+    body1 = cd1->ptr.link->getFirstCollisionBodyTransformIndex() + cd1->shape_index;
+    body2 = cd2->ptr.link->getFirstCollisionBodyTransformIndex() + cd2->shape_index;
+    d = cdata->link_pair_bounds->getLowerBound(body1, body2);
+  }
+
+  bool single_pass_signed = false;
+  if (d < dist_threshold)
+  {
+    fcl_result.min_distance = dist_threshold;
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+    // for two convex shapes the penetration depth is computed by the distance query itself, so that penetrating pairs
+    // do not need a second, contact computing collision query
+    single_pass_signed = cdata->req->enable_signed_distance && !signed_distance_from_contacts &&
+                         supportsSignedDistance(*o1->collisionGeometry()) &&
+                         supportsSignedDistance(*o2->collisionGeometry());
+    fcl::DistanceRequestd fcl_request(cdata->req->enable_nearest_points || single_pass_signed, single_pass_signed);
+#else
+    fcl::DistanceRequestd fcl_request(cdata->req->enable_nearest_points);
+#endif
+    // the result is never larger than the actual distance, as the query stops at dist_threshold
+    d = fcl::distance(o1, o2, fcl_request, fcl_result);
+  }
+  if (link_pair)
+    cdata->link_pair_bounds->setLowerBound(body1, body2, d);
 
   // Check if either object is already in the map. If not add it or if present
   // check to see if the new distance is closer. If closer remove the existing
@@ -538,7 +608,12 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
       dist_result.normal = (dist_result.nearest_points[1] - dist_result.nearest_points[0]).normalized();
     }
 
-    if (d <= 0 && cdata->req->enable_signed_distance)
+    if (d <= 0 && single_pass_signed)
+    {
+      // the nearest points are the deepest points of each object inside the other one
+      dist_result.normal = (dist_result.nearest_points[0] - dist_result.nearest_points[1]).normalized();
+    }
+    else if (d <= 0 && cdata->req->enable_signed_distance)
     {
       dist_result.nearest_points[0].setZero();
       dist_result.nearest_points[1].setZero();
@@ -547,7 +622,7 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
       fcl::CollisionRequestd coll_req;
       fcl::CollisionResultd coll_res;
       coll_req.enable_contact = true;
-      coll_req.num_max_contacts = 200;
+      coll_req.num_max_contacts = MAX_PENETRATION_CONTACTS;
       std::size_t contacts = fcl::collide(o1, o2, coll_req, coll_res);
       if (contacts > 0)
       {
@@ -580,6 +655,8 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
     if (dist_result.distance < cdata->res->minimum_distance.distance)
     {
       cdata->res->minimum_distance = dist_result;
+      cdata->closest_objects[0] = o1;
+      cdata->closest_objects[1] = o2;
     }
 
     if (dist_result.distance <= 0)
@@ -621,6 +698,11 @@ bool distanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void
     }
   }
 
+  // the broadphase can skip pairs whose bounding boxes are farther apart than any distance that is still of interest
+  min_dist = std::min(min_dist, cdata->req->distance_threshold);
+  if (cdata->req->type == DistanceRequestType::GLOBAL && cdata->res->minimum_distance.distance > 0)
+    min_dist = std::min(min_dist, cdata->res->minimum_distance.distance);
+
   return cdata->done;
 }
 
@@ -931,3 +1013,35 @@ void collision_detection::FCLObject::clear()
   collision_objects_.clear();
   collision_geometry_.clear();
 }
+
+bool collision_detection::DistanceQueryHint::setObject(std::size_t side, const fcl::CollisionObjectd* co,
+                                                       const FCLObject& fcl_obj)
+{
+  for (std::size_t i = 0; i < fcl_obj.collision_objects_.size(); ++i)
+    if (fcl_obj.collision_objects_[i].get() == co)
+    {
+      const CollisionGeometryData* cd = static_cast<const CollisionGeometryData*>(co->collisionGeometry()->getUserData());
+      types[side] = cd->type;
+      ids[side] = cd->getID();
+      raw[side] = cd->ptr.raw;
+      shape_indices[side] = cd->shape_index;
+      indices[side] = i;
+      return true;
+    }
+  return false;
+}
+
+fcl::CollisionObjectd* collision_detection::DistanceQueryHint::getObject(std::size_t side,
+                                                                         const FCLObject& fcl_obj) const
+{
+  if (!valid || indices[side] >= fcl_obj.collision_objects_.size())
+    return nullptr;
+  fcl::CollisionObjectd* co = fcl_obj.collision_objects_[indices[side]].get();
+  const CollisionGeometryData* cd = static_cast<const CollisionGeometryData*>(co->collisionGeometry()->getUserData());
+  if (cd->type != types[side])
+    return nullptr;
+  // world objects are identified by their id already; their shapes all use shape index 0
+  if (cd->type != BodyTypes::WORLD_OBJECT && (cd->ptr.raw != raw[side] || cd->shape_index != shape_indices[side]))
+    return nullptr;
+  return co;
+}
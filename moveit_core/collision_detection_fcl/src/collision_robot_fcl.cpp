@@ -36,6 +36,7 @@
 
 #include <moveit/collision_detection_fcl/collision_robot_fcl.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <limits>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
@@ -43,6 +44,84 @@
 
 namespace collision_detection
 {
+namespace
+{
+/** \brief Untransformed FCL objects for the shapes of attached bodies. Constructing an FCL object computes the local
+ *  AABB of its geometry, which is expensive for meshes, so collision checks copy these objects and only set their
+ *  transforms. The geometry itself comes from the shape cache of createCollisionGeometry(), which also points it to the
+ *  body that is being checked. Like that cache, each thread keeps its own instance, so no locking is needed. */
+struct AttachedShapeObjectCache
+{
+  struct Entry
+  {
+    /** \brief The geometry the object was created for; not owned, so the shape cache can still update it */
+    std::weak_ptr<const FCLGeometry> geom_;
+    FCLCollisionObjectConstPtr obj_;
+  };
+
+  using ShapeKey = shapes::ShapeConstWeakPtr;
+  using ShapeMap = std::map<ShapeKey, Entry, std::owner_less<ShapeKey>>;
+
+  const FCLCollisionObjectConstPtr& getObject(const shapes::ShapeConstPtr& shape, const FCLGeometryConstPtr& geom)
+  {
+    ShapeMap::iterator it = map_.find(shape);
+    if (it != map_.end() && it->second.geom_.lock() == geom)
+      return it->second.obj_;
+
+    // on a miss, release the objects (and with them the geometry) of shapes and geometries that no longer exist
+    removeExpired();
+    Entry& entry = map_[shape];
+    entry.geom_ = geom;
+    entry.obj_.reset(new fcl::CollisionObjectd(geom->collision_geometry_));
+    return entry.obj_;
+  }
+
+  void removeExpired()
+  {
+    for (ShapeMap::iterator it = map_.begin(); it != map_.end();)
+      if (it->first.expired() || it->second.geom_.expired())
+        it = map_.erase(it);
+      else
+        ++it;
+  }
+
+  ShapeMap map_;
+};
+
+AttachedShapeObjectCache& getAttachedShapeObjectCache()
+{
+  static thread_local AttachedShapeObjectCache cache;
+  return cache;
+}
+}  // namespace
+
+/** \brief The center of the local bounding sphere of a collision geometry, whose radius is geom.aabb_radius */
+static Eigen::Vector3d getBoundingSphereCenter(const fcl::CollisionGeometryd& geom)
+{
+#if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
+  return geom.aabb_center;
+#else
+  return Eigen::Vector3d(geom.aabb_center[0], geom.aabb_center[1], geom.aabb_center[2]);
+#endif
+}
+
+/** \brief The largest distance of a body of a link from the link's origin, taken from the local bounding sphere of its
+ *  (padded and scaled) geometry */
+static double getBodyReach(const robot_model::LinkModel* link, std::size_t shape_index,
+                           const fcl::CollisionGeometryd& geom)
+{
+  return link->getCollisionOriginTransforms()[shape_index].translation().norm() +
+         getBoundingSphereCenter(geom).norm() + geom.aabb_radius;
+}
+
+/** \brief Extend \e aabb by the bounding sphere of \e geom, placed at \e pose */
+static void extendAABB(const fcl::CollisionGeometryd& geom, const Eigen::Isometry3d& pose, Eigen::AlignedBox3d& aabb)
+{
+  const Eigen::Vector3d center = pose * getBoundingSphereCenter(geom);
+  aabb.extend(center - Eigen::Vector3d::Constant(geom.aabb_radius));
+  aabb.extend(center + Eigen::Vector3d::Constant(geom.aabb_radius));
+}
+
 CollisionRobotFCL::CollisionRobotFCL(const robot_model::RobotModelConstPtr& model, double padding, double scale)
   : CollisionRobot(model, padding, scale)
 {
@@ -71,12 +150,29 @@ CollisionRobotFCL::CollisionRobotFCL(const robot_model::RobotModelConstPtr& mode
         ROS_ERROR_NAMED("collision_detection.fcl", "Unable to construct collision geometry for link '%s'",
                         link->getName().c_str());
     }
+  initDistanceBounds();
 }
 
 CollisionRobotFCL::CollisionRobotFCL(const CollisionRobotFCL& other) : CollisionRobot(other)
 {
   geoms_ = other.geoms_;
   fcl_objs_ = other.fcl_objs_;
+  initDistanceBounds();
+}
+
+void CollisionRobotFCL::initDistanceBounds()
+{
+  std::vector<double> body_reach(geoms_.size(), std::numeric_limits<double>::infinity());
+  for (std::size_t i = 0; i < geoms_.size(); ++i)
+    if (geoms_[i] && geoms_[i]->collision_geometry_)
+    {
+      // the local bounding sphere is computed when the FCL object is created
+      const CollisionGeometryData& data = *geoms_[i]->collision_geometry_data_;
+      body_reach[i] = getBodyReach(data.ptr.link, data.shape_index, *geoms_[i]->collision_geometry_);
+    }
+
+  boost::mutex::scoped_lock slock(distance_hint_lock_);
+  distance_bounds_ = LinkPairDistanceBounds(robot_model_, body_reach);
 }
 
 void CollisionRobotFCL::getAttachedBodyObjects(const robot_state::AttachedBody* ab,
@@ -91,6 +187,23 @@ void CollisionRobotFCL::getAttachedBodyObjects(const robot_state::AttachedBody*
   }
 }
 
+void CollisionRobotFCL::getAttachedBodyObjects(const robot_state::AttachedBody* ab,
+                                               std::vector<FCLGeometryConstPtr>& geoms,
+                                               std::vector<FCLCollisionObjectConstPtr>& objs) const
+{
+  AttachedShapeObjectCache& cache = getAttachedShapeObjectCache();
+  const std::vector<shapes::ShapeConstPtr>& shapes = ab->getShapes();
+  for (std::size_t i = 0; i < shapes.size(); ++i)
+  {
+    FCLGeometryConstPtr co = createCollisionGeometry(shapes[i], ab, i);
+    if (co)
+    {
+      objs.push_back(cache.getObject(shapes[i], co));
+      geoms.push_back(co);
+    }
+  }
+}
+
 void CollisionRobotFCL::constructFCLObject(const robot_state::RobotState& state, FCLObject& fcl_obj) const
 {
   fcl_obj.collision_objects_.reserve(geoms_.size());
@@ -108,27 +221,55 @@ void CollisionRobotFCL::constructFCLObject(const robot_state::RobotState& state,
       fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(coll_obj));
     }
 
-  // TODO: Implement a method for caching fcl::CollisionObject's for robot_state::AttachedBody's
   std::vector<const robot_state::AttachedBody*> ab;
   state.getAttachedBodies(ab);
+  std::vector<FCLGeometryConstPtr> geoms;
+  std::vector<FCLCollisionObjectConstPtr> objs;
   for (auto& body : ab)
   {
-    std::vector<FCLGeometryConstPtr> objs;
-    getAttachedBodyObjects(body, objs);
+    geoms.clear();
+    objs.clear();
+    getAttachedBodyObjects(body, geoms, objs);
     const EigenSTL::vector_Isometry3d& ab_t = body->getGlobalCollisionBodyTransforms();
-    for (std::size_t k = 0; k < objs.size(); ++k)
-      if (objs[k]->collision_geometry_)
+    for (std::size_t k = 0; k < geoms.size(); ++k)
+      if (geoms[k]->collision_geometry_)
       {
-        transform2fcl(ab_t[k], fcl_tf);
-        fcl_obj.collision_objects_.push_back(
-            FCLCollisionObjectPtr(new fcl::CollisionObjectd(objs[k]->collision_geometry_, fcl_tf)));
+        transform2fcl(ab_t[geoms[k]->collision_geometry_data_->shape_index], fcl_tf);
+        auto coll_obj = new fcl::CollisionObjectd(*objs[k]);
+        coll_obj->setTransform(fcl_tf);
+        coll_obj->computeAABB();
+        fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(coll_obj));
         // we copy the shared ptr to the CollisionGeometryData, as this is not stored by the class itself,
-        // and would be destroyed when objs goes out of scope.
-        fcl_obj.collision_geometry_.push_back(objs[k]);
+        // and would be destroyed when geoms goes out of scope.
+        fcl_obj.collision_geometry_.push_back(geoms[k]);
       }
   }
 }
 
+void CollisionRobotFCL::computeAABB(const robot_state::RobotState& state, Eigen::AlignedBox3d& aabb) const
+{
+  aabb.setEmpty();
+  for (const FCLGeometryConstPtr& geom : geoms_)
+    if (geom && geom->collision_geometry_)
+    {
+      const CollisionGeometryData& data = *geom->collision_geometry_data_;
+      extendAABB(*geom->collision_geometry_, state.getCollisionBodyTransform(data.ptr.link, data.shape_index), aabb);
+    }
+
+  std::vector<const robot_state::AttachedBody*> ab;
+  state.getAttachedBodies(ab);
+  std::vector<FCLGeometryConstPtr> geoms;
+  for (auto& body : ab)
+  {
+    geoms.clear();
+    getAttachedBodyObjects(body, geoms);
+    const EigenSTL::vector_Isometry3d& ab_t = body->getGlobalCollisionBodyTransforms();
+    for (const FCLGeometryConstPtr& geom : geoms)
+      if (geom->collision_geometry_)
+        extendAABB(*geom->collision_geometry_, ab_t[geom->collision_geometry_data_->shape_index], aabb);
+  }
+}
+
 void CollisionRobotFCL::allocSelfCollisionBroadPhase(const robot_state::RobotState& state, FCLManager& manager) const
 {
   auto m = new fcl::DynamicAABBTreeCollisionManagerd();
@@ -276,6 +417,7 @@ void CollisionRobotFCL::updatedPaddingOrScaling(const std::vector<std::string>&
     else
       ROS_ERROR_NAMED("collision_detection.fcl", "Updating padding or scaling for unknown link: '%s'", link.c_str());
   }
+  initDistanceBounds();
 }
 
 void CollisionRobotFCL::distanceSelf(const DistanceRequest& req, DistanceResult& res,
@@ -285,7 +427,49 @@ void CollisionRobotFCL::distanceSelf(const DistanceRequest& req, DistanceResult&
   allocSelfCollisionBroadPhase(state, manager);
   DistanceData drd(&req, &res);
 
+  // the link pair distances of the previous query are taken over (concurrent queries start without them), and only
+  // the pairs that may have come closer than the distance of interest since then are evaluated
+  LinkPairDistanceBounds bounds;
+  {
+    boost::mutex::scoped_lock slock(distance_hint_lock_);
+    std::swap(bounds, distance_bounds_);
+  }
+  bounds.update(state);
+  drd.link_pair_bounds = &bounds;
+
+  if (req.type == DistanceRequestType::GLOBAL)
+  {
+    // repeated queries usually come from similar states; starting with the pair that was closest last time gives a
+    // tight bound for pruning all other pairs
+    DistanceQueryHint hint;
+    {
+      boost::mutex::scoped_lock slock(distance_hint_lock_);
+      hint = distance_hint_;
+    }
+    fcl::CollisionObjectd* o1 = hint.getObject(0, manager.object_);
+    fcl::CollisionObjectd* o2 = hint.getObject(1, manager.object_);
+    if (o1 && o2)
+    {
+      double min_dist = std::numeric_limits<double>::max();
+      distanceCallback(o1, o2, &drd, min_dist);
+    }
+  }
+
   manager.manager_->distance(&drd, &distanceCallback);
+
+  if (req.type == DistanceRequestType::GLOBAL && drd.closest_objects[0])
+  {
+    DistanceQueryHint hint;
+    hint.valid = hint.setObject(0, drd.closest_objects[0], manager.object_) &&
+                 hint.setObject(1, drd.closest_objects[1], manager.object_);
+    boost::mutex::scoped_lock slock(distance_hint_lock_);
+    distance_hint_ = hint;
+  }
+
+  // a query that started without the bounds, or ran while they were set up again, does not replace them
+  boost::mutex::scoped_lock slock(distance_hint_lock_);
+  if (!distance_bounds_.isInitialized())
+    std::swap(bounds, distance_bounds_);
 }
 
 void CollisionRobotFCL::distanceOther(const DistanceRequest& req, DistanceResult& res,
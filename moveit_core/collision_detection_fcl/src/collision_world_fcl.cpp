@@ -37,25 +37,103 @@
 #include <moveit/collision_detection_fcl/collision_world_fcl.h>
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
 #include <moveit/collision_detection_fcl/fcl_compat.h>
+#include <geometric_shapes/shapes.h>
 
 #if (MOVEIT_FCL_VERSION >= FCL_VERSION_CHECK(0, 6, 0))
 #include <fcl/geometry/geometric_shape_to_BVH_model.h>
 #include <fcl/narrowphase/detail/traversal/collision/bvh_collision_traversal_node.h>
 #include <fcl/narrowphase/detail/traversal/collision_node.h>
 #include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+#include <fcl/geometry/shape/box.h>
 #else
 #include <fcl/shape/geometric_shape_to_BVH_model.h>
 #include <fcl/traversal/traversal_node_bvhs.h>
 #include <fcl/traversal/traversal_node_setup.h>
 #include <fcl/collision_node.h>
+#include <fcl/shape/geometric_shapes.h>
 #endif
 
 #include <boost/bind.hpp>
+#include <algorithm>
 
 namespace collision_detection
 {
 const std::string CollisionDetectorAllocatorFCL::NAME("FCL");
 
+namespace
+{
+typedef std::unordered_map<const fcl::CollisionObjectd*, FCLCollisionObjectPtr> HiddenObjectMap;
+typedef std::unordered_map<const fcl::CollisionObjectd*, std::pair<FCLCollisionObjectPtr, OctreeOccupancyIndexConstPtr> >
+    OctreeOccupancyMap;
+
+/** \brief Callback data for queries against shared broadphase structures, which may still contain collision objects
+    that were changed or removed in the world using them */
+struct SharedManagerData
+{
+  SharedManagerData(void* data, const HiddenObjectMap* hidden1, const HiddenObjectMap* hidden2 = nullptr)
+    : data_(data), hidden1_(hidden1), hidden2_(hidden2)
+  {
+  }
+
+  bool isHidden(const fcl::CollisionObjectd* o) const
+  {
+    return (hidden1_ && !hidden1_->empty() && hidden1_->count(o)) ||
+           (hidden2_ && !hidden2_->empty() && hidden2_->count(o));
+  }
+
+  /** \brief If one of the objects is an indexed octree, check whether the bounding box of the other one contains any
+      of its occupied leaves */
+  bool mayCollide(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2) const
+  {
+    if (!octrees_ || octrees_->empty())
+      return true;
+    auto it = octrees_->find(o1);
+    if (it == octrees_->end())
+    {
+      it = octrees_->find(o2);
+      if (it == octrees_->end())
+        return true;
+      std::swap(o1, o2);
+    }
+    const auto& aabb = o2->getAABB();
+    return it->second.second->mayBeOccupied(Eigen::Vector3d(aabb.min_[0], aabb.min_[1], aabb.min_[2]),
+                                            Eigen::Vector3d(aabb.max_[0], aabb.max_[1], aabb.max_[2]));
+  }
+
+  void* data_;
+  const HiddenObjectMap* hidden1_;
+  const HiddenObjectMap* hidden2_;
+  const OctreeOccupancyMap* octrees_ = nullptr;
+};
+
+bool sharedCollisionCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  const SharedManagerData* sdata = reinterpret_cast<const SharedManagerData*>(data);
+  if (sdata->isHidden(o1) || sdata->isHidden(o2) || !sdata->mayCollide(o1, o2))
+    return reinterpret_cast<CollisionData*>(sdata->data_)->done_;
+  return collisionCallback(o1, o2, sdata->data_);
+}
+
+/** \brief Callback of a query with the bounding box of a whole robot; data_ points to a flag that is set if any
+    object that is not hidden may collide with the box */
+bool robotBoundsCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+  const SharedManagerData* sdata = reinterpret_cast<const SharedManagerData*>(data);
+  if (sdata->isHidden(o1) || sdata->isHidden(o2) || !sdata->mayCollide(o1, o2))
+    return false;
+  *reinterpret_cast<bool*>(sdata->data_) = true;
+  return true;
+}
+
+bool sharedDistanceCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& min_dist)
+{
+  const SharedManagerData* sdata = reinterpret_cast<const SharedManagerData*>(data);
+  if (sdata->isHidden(o1) || sdata->isHidden(o2))
+    return reinterpret_cast<DistanceData*>(sdata->data_)->done;
+  return distanceCallback(o1, o2, sdata->data_, min_dist);
+}
+}  // namespace
+
 CollisionWorldFCL::CollisionWorldFCL() : CollisionWorld()
 {
   auto m = new fcl::DynamicAABBTreeCollisionManagerd();
@@ -84,9 +162,20 @@ CollisionWorldFCL::CollisionWorldFCL(const CollisionWorldFCL& other, const World
   // m->tree_init_level = 2;
   manager_.reset(m);
 
+  // the broadphase structure of other is shared instead of rebuilt; only the objects other keeps on top of its own
+  // shared structure are registered again
   fcl_objs_ = other.fcl_objs_;
-  for (auto& fcl_obj : fcl_objs_)
-    fcl_obj.second.registerTo(manager_.get());
+  if (other.shared_manager_)
+  {
+    shared_manager_ = other.shared_manager_;
+    hidden_shared_objs_ = other.hidden_shared_objs_;
+    unshared_objs_ = other.unshared_objs_;
+    for (std::size_t index : unshared_objs_)
+      fcl_objs_[index].registerTo(manager_.get());
+  }
+  else
+    shared_manager_ = other.manager_;
+  octree_occupancy_ = other.octree_occupancy_;
   // manager_->update();
 
   // request notifications about changes to new world
@@ -131,13 +220,39 @@ void CollisionWorldFCL::checkRobotCollisionHelper(const CollisionRequest& req, C
                                                   const AllowedCollisionMatrix* acm) const
 {
   const CollisionRobotFCL& robot_fcl = dynamic_cast<const CollisionRobotFCL&>(robot);
-  FCLObject fcl_obj;
-  robot_fcl.constructFCLObject(state, fcl_obj);
+  // links whose bounding box contains no occupied octomap leaf cannot collide with the octomap; cost sources are
+  // computed from the unoccupied leaves as well, though
+  const OctreeOccupancyMap* octrees = octree_occupancy_.empty() || req.cost ? nullptr : &octree_occupancy_;
+
+  // states far from all obstacles are ruled out by a single query with the bounding box of the whole robot, before
+  // the FCL objects of its links are built
+  Eigen::AlignedBox3d robot_aabb;
+  robot_fcl.computeAABB(state, robot_aabb);
+  if (robot_aabb.isEmpty() || mayOverlap(robot_aabb, octrees != nullptr))
+  {
+    FCLObject fcl_obj;
+    robot_fcl.constructFCLObject(state, fcl_obj);
 
-  CollisionData cd(&req, &res, acm);
-  cd.enableGroup(robot.getRobotModel());
-  for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
-    manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+    CollisionData cd(&req, &res, acm);
+    cd.enableGroup(robot.getRobotModel());
+    if (octrees)
+    {
+      SharedManagerData octree_cd(&cd, nullptr);
+      octree_cd.octrees_ = octrees;
+      for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+        manager_->collide(fcl_obj.collision_objects_[i].get(), &octree_cd, &sharedCollisionCallback);
+    }
+    else
+      for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+        manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+    if (shared_manager_)
+    {
+      SharedManagerData shared_cd(&cd, &hidden_shared_objs_);
+      shared_cd.octrees_ = octrees;
+      for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+        shared_manager_->collide(fcl_obj.collision_objects_[i].get(), &shared_cd, &sharedCollisionCallback);
+    }
+  }
 
   if (req.distance)
   {
@@ -152,6 +267,25 @@ void CollisionWorldFCL::checkRobotCollisionHelper(const CollisionRequest& req, C
   }
 }
 
+bool CollisionWorldFCL::mayOverlap(const Eigen::AlignedBox3d& aabb, bool use_octree_index) const
+{
+  const Eigen::Vector3d size = aabb.sizes();
+  fcl::CollisionObjectd box(std::shared_ptr<fcl::CollisionGeometryd>(new fcl::Boxd(size.x(), size.y(), size.z())),
+                            transform2fcl(Eigen::Isometry3d(Eigen::Translation3d(aabb.center()))));
+
+  // the broadphase reports every object whose bounding box overlaps the box
+  bool overlap = false;
+  SharedManagerData box_data(&overlap, nullptr);
+  box_data.octrees_ = use_octree_index ? &octree_occupancy_ : nullptr;
+  manager_->collide(&box, &box_data, &robotBoundsCallback);
+  if (!overlap && shared_manager_)
+  {
+    box_data.hidden1_ = &hidden_shared_objs_;
+    shared_manager_->collide(&box, &box_data, &robotBoundsCallback);
+  }
+  return overlap;
+}
+
 void CollisionWorldFCL::checkWorldCollision(const CollisionRequest& req, CollisionResult& res,
                                             const CollisionWorld& other_world) const
 {
@@ -170,7 +304,19 @@ void CollisionWorldFCL::checkWorldCollisionHelper(const CollisionRequest& req, C
 {
   const CollisionWorldFCL& other_fcl_world = dynamic_cast<const CollisionWorldFCL&>(other_world);
   CollisionData cd(&req, &res, acm);
-  manager_->collide(other_fcl_world.manager_.get(), &cd, &collisionCallback);
+  auto collide = [&cd](fcl::BroadPhaseCollisionManagerd* manager1, const HiddenObjectMap* hidden1,
+                       fcl::BroadPhaseCollisionManagerd* manager2, const HiddenObjectMap* hidden2) {
+    if (!cd.done_ && manager1 && manager2)
+    {
+      SharedManagerData shared_cd(&cd, hidden1, hidden2);
+      manager1->collide(manager2, &shared_cd, &sharedCollisionCallback);
+    }
+  };
+  collide(manager_.get(), nullptr, other_fcl_world.manager_.get(), nullptr);
+  collide(manager_.get(), nullptr, other_fcl_world.shared_manager_.get(), &other_fcl_world.hidden_shared_objs_);
+  collide(shared_manager_.get(), &hidden_shared_objs_, other_fcl_world.manager_.get(), nullptr);
+  collide(shared_manager_.get(), &hidden_shared_objs_, other_fcl_world.shared_manager_.get(),
+          &other_fcl_world.hidden_shared_objs_);
 
   if (req.distance)
   {
@@ -198,39 +344,129 @@ void CollisionWorldFCL::constructFCLObject(const World::Object* obj, FCLObject&
   }
 }
 
-void CollisionWorldFCL::updateFCLObject(const std::string& id)
+void CollisionWorldFCL::updateFCLObject(const World::Object* obj)
 {
-  // remove FCL objects that correspond to this object
-  auto jt = fcl_objs_.find(id);
-  if (jt != fcl_objs_.end())
-  {
-    jt->second.unregisterFrom(manager_.get());
-    jt->second.clear();
-  }
+  // replace the FCL objects that correspond to this object
+  FCLObject& fcl_obj = getFCLObject(obj->index_);
+  unregisterFCLObject(obj->index_, fcl_obj);
+  fcl_obj.clear();
+  constructFCLObject(obj, fcl_obj);
+  registerFCLObject(obj->index_, fcl_obj);
+
+  // manager_->update();
+}
+
+FCLObject& CollisionWorldFCL::getFCLObject(std::size_t index)
+{
+  if (fcl_objs_.size() <= index)
+    fcl_objs_.resize(std::max(index + 1, getWorld()->getObjectIndexBound()));
+  return fcl_objs_[index];
+}
 
-  // check to see if we have this object
-  auto it = getWorld()->find(id);
-  if (it != getWorld()->end())
+const FCLObject* CollisionWorldFCL::findFCLObject(std::size_t index) const
+{
+  return index < fcl_objs_.size() ? &fcl_objs_[index] : nullptr;
+}
+
+bool CollisionWorldFCL::updateFCLObjectTransforms(const World::Object* obj)
+{
+  // collision objects are only matched to shapes by index if every shape produced one
+  if (obj->index_ >= fcl_objs_.size() || fcl_objs_[obj->index_].collision_objects_.size() != obj->shapes_.size())
+    return false;
+
+  // the geometry refers back to the object it was created for; when the world copied the object before moving it
+  // (because it was shared with another world), the geometry has to be reconstructed for the new object
+  FCLObject& fcl_obj = fcl_objs_[obj->index_];
+  for (const FCLGeometryConstPtr& geometry : fcl_obj.collision_geometry_)
+    if (geometry->collision_geometry_data_->ptr.obj != obj)
+      return false;
+
+  // objects in a shared broadphase structure are never modified; they are hidden and replaced in manager_ instead
+  const bool in_shared_manager = shared_manager_ && unshared_objs_.find(obj->index_) == unshared_objs_.end();
+  if (in_shared_manager)
+    unregisterFCLObject(obj->index_, fcl_obj);
+
+  for (std::size_t i = 0; i < fcl_obj.collision_objects_.size(); ++i)
   {
-    // construct FCL objects that correspond to this object
-    if (jt != fcl_objs_.end())
+    if (!in_shared_manager && fcl_obj.collision_objects_[i].unique())
     {
-      constructFCLObject(it->second.get(), jt->second);
-      jt->second.registerTo(manager_.get());
+      // only this world uses the object, so it can be moved in place
+      fcl::CollisionObjectd* co = fcl_obj.collision_objects_[i].get();
+      co->setTransform(transform2fcl(obj->shape_poses_[i]));
+      co->computeAABB();
+      manager_->update(co);
     }
     else
     {
-      constructFCLObject(it->second.get(), fcl_objs_[id]);
-      fcl_objs_[id].registerTo(manager_.get());
+      // the object is shared with another world; use a new object with the same geometry
+      if (!in_shared_manager)
+        manager_->unregisterObject(fcl_obj.collision_objects_[i].get());
+      fcl_obj.collision_objects_[i].reset(new fcl::CollisionObjectd(fcl_obj.collision_geometry_[i]->collision_geometry_,
+                                                                    transform2fcl(obj->shape_poses_[i])));
+      if (!in_shared_manager)
+        manager_->registerObject(fcl_obj.collision_objects_[i].get());
     }
   }
+
+  if (in_shared_manager)
+    registerFCLObject(obj->index_, fcl_obj);
+  return true;
+}
+
+void CollisionWorldFCL::indexOctrees(const World::Object* obj, const FCLObject& fcl_obj)
+{
+  // collision objects are only matched to shapes by index if every shape produced one
+  if (fcl_obj.collision_objects_.size() != obj->shapes_.size())
+    return;
+  for (std::size_t i = 0; i < obj->shapes_.size(); ++i)
+    if (obj->shapes_[i]->type == shapes::OCTREE)
+    {
+      const shapes::OcTree* octree = static_cast<const shapes::OcTree*>(obj->shapes_[i].get());
+      if (octree->octree)
+        octree_occupancy_[fcl_obj.collision_objects_[i].get()] =
+            std::make_pair(fcl_obj.collision_objects_[i],
+                           std::make_shared<const OctreeOccupancyIndex>(*octree->octree, obj->shape_poses_[i]));
+    }
+}
+
+void CollisionWorldFCL::unregisterFCLObject(std::size_t index, FCLObject& fcl_obj)
+{
+  if (shared_manager_ && unshared_objs_.find(index) == unshared_objs_.end())
+  {
+    for (const FCLCollisionObjectPtr& co : fcl_obj.collision_objects_)
+      hidden_shared_objs_[co.get()] = co;
+  }
   else
+    fcl_obj.unregisterFrom(manager_.get());
+}
+
+void CollisionWorldFCL::registerFCLObject(std::size_t index, FCLObject& fcl_obj)
+{
+  fcl_obj.registerTo(manager_.get());
+  if (shared_manager_)
+    unshared_objs_.insert(index);
+}
+
+void CollisionWorldFCL::unshareManager()
+{
+  // only a world that does not use a shared structure itself hands out manager_ to its copies
+  if (manager_.use_count() > 1)
   {
-    if (jt != fcl_objs_.end())
-      fcl_objs_.erase(jt);
+    shared_manager_ = manager_;
+    hidden_shared_objs_.clear();
+    unshared_objs_.clear();
+    manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
   }
+}
 
-  // manager_->update();
+void CollisionWorldFCL::rebuildManager()
+{
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
+  shared_manager_.reset();
+  hidden_shared_objs_.clear();
+  unshared_objs_.clear();
+  for (FCLObject& fcl_obj : fcl_objs_)
+    fcl_obj.registerTo(manager_.get());
 }
 
 void CollisionWorldFCL::setWorld(const WorldPtr& world)
@@ -242,8 +478,12 @@ void CollisionWorldFCL::setWorld(const WorldPtr& world)
   getWorld()->removeObserver(observer_handle_);
 
   // clear out objects from old world
-  manager_->clear();
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
+  shared_manager_.reset();
+  hidden_shared_objs_.clear();
+  unshared_objs_.clear();
   fcl_objs_.clear();
+  octree_occupancy_.clear();
   cleanCollisionGeometryCache();
 
   CollisionWorld::setWorld(world);
@@ -257,23 +497,39 @@ void CollisionWorldFCL::setWorld(const WorldPtr& world)
 
 void CollisionWorldFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
+  unshareManager();
+
+  // octomaps are indexed again after every change
+  const FCLObject* old_fcl_obj = findFCLObject(obj->index_);
+  if (old_fcl_obj && !octree_occupancy_.empty())
+    for (const FCLCollisionObjectPtr& co : old_fcl_obj->collision_objects_)
+      octree_occupancy_.erase(co.get());
+
   if (action == World::DESTROY)
   {
-    auto it = fcl_objs_.find(obj->id_);
-    if (it != fcl_objs_.end())
+    // the world gives the index to new objects once this notification is delivered, so nothing of this object may
+    // be left in its entry
+    if (obj->index_ < fcl_objs_.size())
     {
-      it->second.unregisterFrom(manager_.get());
-      it->second.clear();
-      fcl_objs_.erase(it);
+      unregisterFCLObject(obj->index_, fcl_objs_[obj->index_]);
+      fcl_objs_[obj->index_].clear();
     }
+    unshared_objs_.erase(obj->index_);
     cleanCollisionGeometryCache();
   }
-  else
+  else if (action != World::MOVE_SHAPE || !updateFCLObjectTransforms(obj.get()))
   {
-    updateFCLObject(obj->id_);
+    updateFCLObject(obj.get());
     if (action & (World::DESTROY | World::REMOVE_SHAPE))
       cleanCollisionGeometryCache();
   }
+
+  if (action != World::DESTROY)
+    indexOctrees(obj.get(), fcl_objs_[obj->index_]);
+
+  // once most of the shared structure is outdated, queries are cheaper on a structure of our own
+  if (shared_manager_ && 2 * hidden_shared_objs_.size() > shared_manager_->size())
+    rebuildManager();
 }
 
 void CollisionWorldFCL::distanceRobot(const DistanceRequest& req, DistanceResult& res, const CollisionRobot& robot,
@@ -283,9 +539,58 @@ void CollisionWorldFCL::distanceRobot(const DistanceRequest& req, DistanceResult
   FCLObject fcl_obj;
   robot_fcl.constructFCLObject(state, fcl_obj);
 
+  // the FCL objects a collision object of the closest pair belongs to
+  auto hint_objects = [this, &fcl_obj](BodyType type, const std::string& id) -> const FCLObject* {
+    if (type != BodyTypes::WORLD_OBJECT)
+      return &fcl_obj;
+    auto it = getWorld()->find(id);
+    return it == getWorld()->end() ? nullptr : findFCLObject(it->second->index_);
+  };
+
   DistanceData drd(&req, &res);
+  if (req.type == DistanceRequestType::GLOBAL)
+  {
+    // repeated queries usually come from similar states; starting with the pair that was closest last time gives a
+    // tight bound for pruning all other pairs
+    DistanceQueryHint hint;
+    {
+      boost::mutex::scoped_lock slock(distance_hint_lock_);
+      hint = distance_hint_;
+    }
+    fcl::CollisionObjectd* objs[2] = { nullptr, nullptr };
+    for (std::size_t side = 0; hint.valid && side < 2; ++side)
+      if (const FCLObject* hint_obj = hint_objects(hint.types[side], hint.ids[side]))
+        objs[side] = hint.getObject(side, *hint_obj);
+    if (objs[0] && objs[1])
+    {
+      double min_dist = std::numeric_limits<double>::max();
+      distanceCallback(objs[0], objs[1], &drd, min_dist);
+    }
+  }
+
   for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
     manager_->distance(fcl_obj.collision_objects_[i].get(), &drd, &distanceCallback);
+  if (shared_manager_)
+  {
+    SharedManagerData shared_drd(&drd, &hidden_shared_objs_);
+    for (std::size_t i = 0; !drd.done && i < fcl_obj.collision_objects_.size(); ++i)
+      shared_manager_->distance(fcl_obj.collision_objects_[i].get(), &shared_drd, &sharedDistanceCallback);
+  }
+
+  if (req.type == DistanceRequestType::GLOBAL && drd.closest_objects[0])
+  {
+    DistanceQueryHint hint;
+    hint.valid = true;
+    for (std::size_t side = 0; hint.valid && side < 2; ++side)
+    {
+      const CollisionGeometryData* cd =
+          static_cast<const CollisionGeometryData*>(drd.closest_objects[side]->collisionGeometry()->getUserData());
+      const FCLObject* hint_obj = hint_objects(cd->type, cd->getID());
+      hint.valid = hint_obj && hint.setObject(side, drd.closest_objects[side], *hint_obj);
+    }
+    boost::mutex::scoped_lock slock(distance_hint_lock_);
+    distance_hint_ = hint;
+  }
 }
 
 void CollisionWorldFCL::distanceWorld(const DistanceRequest& req, DistanceResult& res,
@@ -293,7 +598,19 @@ void CollisionWorldFCL::distanceWorld(const DistanceRequest& req, DistanceResult
 {
   const CollisionWorldFCL& other_fcl_world = dynamic_cast<const CollisionWorldFCL&>(world);
   DistanceData drd(&req, &res);
-  manager_->distance(other_fcl_world.manager_.get(), &drd, &distanceCallback);
+  auto distance = [&drd](fcl::BroadPhaseCollisionManagerd* manager1, const HiddenObjectMap* hidden1,
+                         fcl::BroadPhaseCollisionManagerd* manager2, const HiddenObjectMap* hidden2) {
+    if (!drd.done && manager1 && manager2)
+    {
+      SharedManagerData shared_drd(&drd, hidden1, hidden2);
+      manager1->distance(manager2, &shared_drd, &sharedDistanceCallback);
+    }
+  };
+  distance(manager_.get(), nullptr, other_fcl_world.manager_.get(), nullptr);
+  distance(manager_.get(), nullptr, other_fcl_world.shared_manager_.get(), &other_fcl_world.hidden_shared_objs_);
+  distance(shared_manager_.get(), &hidden_shared_objs_, other_fcl_world.manager_.get(), nullptr);
+  distance(shared_manager_.get(), &hidden_shared_objs_, other_fcl_world.shared_manager_.get(),
+           &other_fcl_world.hidden_shared_objs_);
 }
 
 }  // end of namespace collision_detection
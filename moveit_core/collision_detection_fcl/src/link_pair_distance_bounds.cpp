@@ -0,0 +1,167 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection_fcl/link_pair_distance_bounds.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace collision_detection
+{
+LinkPairDistanceBounds::LinkPairDistanceBounds() : body_count_(0)
+{
+}
+
+LinkPairDistanceBounds::LinkPairDistanceBounds(const robot_model::RobotModelConstPtr& model,
+                                               const std::vector<double>& body_reach)
+  : body_count_(body_reach.size()), joint_motion_(model->getJointModelCount(), 0.0)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  auto chains = std::make_shared<BodyChains>(body_count_);
+  for (const robot_model::LinkModel* link : model->getLinkModelsWithCollisionGeometry())
+    for (std::size_t i = 0; i < link->getShapes().size(); ++i)
+    {
+      std::size_t body = link->getFirstCollisionBodyTransformIndex() + i;
+      if (body >= body_count_)
+        continue;
+
+      // the largest distance of the body from the origin of the current link, over all configurations
+      double reach = body_reach[body];
+      for (const robot_model::LinkModel* l = link; l && l->getParentJointModel(); l = l->getParentLinkModel())
+      {
+        // the axis of the parent joint passes through the origin of its child link
+        const robot_model::JointModel* joint = l->getParentJointModel();
+        switch (joint->getType())
+        {
+          case robot_model::JointModel::FIXED:
+            break;
+          case robot_model::JointModel::REVOLUTE:
+            (*chains)[body].emplace_back(joint->getJointIndex(), reach);
+            break;
+          case robot_model::JointModel::PRISMATIC:
+          {
+            (*chains)[body].emplace_back(joint->getJointIndex(), 1.0);
+            const robot_model::VariableBounds& bounds = joint->getVariableBounds()[0];
+            reach += bounds.position_bounded_ ?
+                         std::max(std::fabs(bounds.min_position_), std::fabs(bounds.max_position_)) :
+                         inf;
+            break;
+          }
+          default:
+            // planar and floating joints are not bounded by a single factor; any change of them disables the bound
+            (*chains)[body].emplace_back(joint->getJointIndex(), inf);
+            reach = inf;
+        }
+        reach += l->getJointOriginTransform().translation().norm();
+      }
+    }
+  chains_ = chains;
+  bounds_.assign(body_count_ * body_count_, -inf);
+}
+
+void LinkPairDistanceBounds::update(const robot_state::RobotState& state)
+{
+  if (!chains_)
+    return;
+
+  const double inf = std::numeric_limits<double>::infinity();
+  const double* positions = state.getVariablePositions();
+  if (previous_positions_.size() == state.getVariableCount())
+  {
+    for (const robot_model::JointModel* joint : state.getRobotModel()->getJointModels())
+    {
+      double motion = 0.0;
+      for (std::size_t i = joint->getFirstVariableIndex(), end = i + joint->getVariableCount(); i < end; ++i)
+        motion = std::max(motion, std::fabs(positions[i] - previous_positions_[i]));
+      joint_motion_[joint->getJointIndex()] = motion;
+    }
+    previous_bounds_.swap(bounds_);
+  }
+  else
+    previous_bounds_.assign(body_count_ * body_count_, -inf);
+
+  bounds_.assign(body_count_ * body_count_, -inf);
+  previous_positions_.assign(positions, positions + state.getVariableCount());
+}
+
+void LinkPairDistanceBounds::clear()
+{
+  previous_positions_.clear();
+  std::fill(bounds_.begin(), bounds_.end(), -std::numeric_limits<double>::infinity());
+}
+
+double LinkPairDistanceBounds::getLowerBound(std::size_t body1, std::size_t body2) const
+{
+  if (body1 >= body_count_ || body2 >= body_count_)
+    return -std::numeric_limits<double>::infinity();
+
+  std::size_t index = std::min(body1, body2) * body_count_ + std::max(body1, body2);
+  double bound = bounds_[index];
+  if (previous_bounds_.size() == bounds_.size() && previous_bounds_[index] > bound)
+    bound = std::max(bound, previous_bounds_[index] - getRelativeMotion(body1, body2));
+  return bound;
+}
+
+void LinkPairDistanceBounds::setLowerBound(std::size_t body1, std::size_t body2, double distance)
+{
+  if (body1 >= body_count_ || body2 >= body_count_)
+    return;
+
+  double& bound = bounds_[std::min(body1, body2) * body_count_ + std::max(body1, body2)];
+  bound = std::max(bound, distance);
+}
+
+double LinkPairDistanceBounds::getRelativeMotion(std::size_t body1, std::size_t body2) const
+{
+  const std::vector<std::pair<int, double> >& chain1 = (*chains_)[body1];
+  const std::vector<std::pair<int, double> >& chain2 = (*chains_)[body2];
+
+  // the joints both bodies descend from move them together
+  std::size_t end1 = chain1.size(), end2 = chain2.size();
+  while (end1 > 0 && end2 > 0 && chain1[end1 - 1].first == chain2[end2 - 1].first)
+  {
+    --end1;
+    --end2;
+  }
+
+  double motion = 0.0;
+  for (std::size_t i = 0; i < end1; ++i)
+    if (joint_motion_[chain1[i].first] > 0.0)
+      motion += joint_motion_[chain1[i].first] * chain1[i].second;
+  for (std::size_t i = 0; i < end2; ++i)
+    if (joint_motion_[chain2[i].first] > 0.0)
+      motion += joint_motion_[chain2[i].first] * chain2[i].second;
+  return motion;
+}
+}
@@ -0,0 +1,100 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection_fcl/octree_occupancy_index.h>
+#include <cmath>
+
+namespace collision_detection
+{
+namespace
+{
+// cells are this many octree leaves wide, which keeps the number of lookups per query box small
+const double CELLS_PER_LEAF = 4.0;
+
+// query boxes covering more cells than this are not checked against the index
+const std::int64_t MAX_QUERY_CELLS = 4096;
+
+// coordinates are stored in 21 bits each, with this offset
+const std::int64_t KEY_OFFSET = 1 << 20;
+}  // namespace
+
+OctreeOccupancyIndex::OctreeOccupancyIndex(const octomap::OcTree& octree, const Eigen::Isometry3d& pose)
+  : cell_size_(octree.getResolution() * CELLS_PER_LEAF)
+{
+  const Eigen::Matrix3d abs_rotation = pose.linear().cwiseAbs();
+  for (auto it = octree.begin_leafs(), end = octree.end_leafs(); it != end; ++it)
+  {
+    if (!octree.isNodeOccupied(*it))
+      continue;
+
+    // bounding box of the leaf in the world, marked in every cell it touches
+    const octomap::point3d& c = it.getCoordinate();
+    const Eigen::Vector3d center = pose * Eigen::Vector3d(c.x(), c.y(), c.z());
+    const Eigen::Vector3d half_extents = abs_rotation * Eigen::Vector3d::Constant(it.getSize() / 2.0);
+    const Eigen::Vector3d min = ((center - half_extents) / cell_size_).array().floor().matrix();
+    const Eigen::Vector3d max = ((center + half_extents) / cell_size_).array().floor().matrix();
+    for (std::int64_t x = static_cast<std::int64_t>(min.x()); x <= max.x(); ++x)
+      for (std::int64_t y = static_cast<std::int64_t>(min.y()); y <= max.y(); ++y)
+        for (std::int64_t z = static_cast<std::int64_t>(min.z()); z <= max.z(); ++z)
+          cells_.insert(cellKey(x, y, z));
+  }
+}
+
+bool OctreeOccupancyIndex::mayBeOccupied(const Eigen::Vector3d& min, const Eigen::Vector3d& max) const
+{
+  if (cells_.empty())
+    return false;
+
+  const Eigen::Vector3d cell_min = (min / cell_size_).array().floor().matrix();
+  const Eigen::Vector3d cell_max = (max / cell_size_).array().floor().matrix();
+  const Eigen::Vector3d count = cell_max - cell_min + Eigen::Vector3d::Ones();
+  if (!count.allFinite() || count.prod() > MAX_QUERY_CELLS)
+    return true;
+
+  for (std::int64_t x = static_cast<std::int64_t>(cell_min.x()); x <= cell_max.x(); ++x)
+    for (std::int64_t y = static_cast<std::int64_t>(cell_min.y()); y <= cell_max.y(); ++y)
+      for (std::int64_t z = static_cast<std::int64_t>(cell_min.z()); z <= cell_max.z(); ++z)
+        if (cells_.find(cellKey(x, y, z)) != cells_.end())
+          return true;
+  return false;
+}
+
+std::uint64_t OctreeOccupancyIndex::cellKey(std::int64_t x, std::int64_t y, std::int64_t z)
+{
+  const std::uint64_t mask = (1 << 21) - 1;
+  return (static_cast<std::uint64_t>(x + KEY_OFFSET) & mask) |
+         ((static_cast<std::uint64_t>(y + KEY_OFFSET) & mask) << 21) |
+         ((static_cast<std::uint64_t>(z + KEY_OFFSET) & mask) << 42);
+}
+}  // namespace collision_detection
@@ -0,0 +1,159 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_detection_fcl/collision_world_fcl.h>
+#include <moveit/collision_detection_fcl/collision_robot_fcl.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <moveit/utils/benchmark_test_utils.h>
+#include <geometric_shapes/shapes.h>
+#include <gtest/gtest.h>
+
+using moveit::core::ScopedTimer;
+
+TEST(Timing, penetratingConvexShapes)
+{
+  // pairs of a sphere and a box that reach 0.1 into each other, far apart from all other pairs
+  collision_detection::CollisionWorldFCL spheres, boxes;
+  shapes::ShapeConstPtr sphere(new shapes::Sphere(0.5));
+  shapes::ShapeConstPtr box(new shapes::Box(1, 1, 1));
+  const std::size_t count = 100;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation().x() = 3.0 * i;
+    spheres.getWorld()->addToObject("sphere" + std::to_string(i), sphere, pose);
+    pose.translation().x() += 0.9;
+    boxes.getWorld()->addToObject("box" + std::to_string(i), box, pose);
+  }
+
+  collision_detection::DistanceRequest req;
+  req.type = collision_detection::DistanceRequestType::ALL;
+  req.enable_nearest_points = true;
+
+  const std::size_t runs = 100;
+  double gold_standard = 0;
+  {
+    ScopedTimer t("Unsigned distances of penetrating convex shapes: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      collision_detection::DistanceResult res;
+      spheres.distanceWorld(req, res, boxes);
+    }
+  }
+
+  // the previous implementation, which runs a collision query for the contacts of every penetrating pair
+  req.enable_signed_distance = true;
+  collision_detection::setSignedDistanceFromContacts(true);
+  collision_detection::DistanceResult contacts_res;
+  {
+    ScopedTimer t("Signed distances of penetrating convex shapes from contacts: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      contacts_res.clear();
+      spheres.distanceWorld(req, contacts_res, boxes);
+    }
+  }
+
+  collision_detection::setSignedDistanceFromContacts(false);
+  collision_detection::DistanceResult res;
+  {
+    ScopedTimer t("Signed distances of penetrating convex shapes: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      res.clear();
+      spheres.distanceWorld(req, res, boxes);
+    }
+  }
+  EXPECT_NEAR(-0.1, res.minimum_distance.distance, 1e-3);
+  EXPECT_NEAR(contacts_res.minimum_distance.distance, res.minimum_distance.distance, 1e-3);
+}
+
+TEST(Timing, penetratingRobotLinks)
+{
+  robot_model::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  collision_detection::CollisionRobotFCL crobot(model);
+  collision_detection::CollisionWorldFCL cworld;
+
+  robot_state::RobotState state(model);
+  state.setToDefaultValues();
+  state.update();
+
+  // a small box at the origin of every link with a (mesh) collision geometry
+  shapes::ShapeConstPtr box(new shapes::Box(0.05, 0.05, 0.05));
+  for (const robot_model::LinkModel* link : model->getLinkModelsWithCollisionGeometry())
+    cworld.getWorld()->addToObject("box_" + link->getName(), box, state.getGlobalLinkTransform(link));
+
+  collision_detection::DistanceRequest req;
+  req.type = collision_detection::DistanceRequestType::ALL;
+  req.enable_nearest_points = true;
+
+  const std::size_t runs = 10;
+  double gold_standard = 0;
+  {
+    ScopedTimer t("Unsigned distances of penetrating robot links: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      collision_detection::DistanceResult res;
+      cworld.distanceRobot(req, res, crobot, state);
+    }
+  }
+
+  req.enable_signed_distance = true;
+  collision_detection::setSignedDistanceFromContacts(true);
+  {
+    ScopedTimer t("Signed distances of penetrating robot links from contacts: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      collision_detection::DistanceResult res;
+      cworld.distanceRobot(req, res, crobot, state);
+    }
+  }
+
+  collision_detection::setSignedDistanceFromContacts(false);
+  {
+    ScopedTimer t("Signed distances of penetrating robot links: ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+      collision_detection::DistanceResult res;
+      cworld.distanceRobot(req, res, crobot, state);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -41,6 +41,7 @@
 #include <moveit/utils/robot_model_test_utils.h>
 
 #include <urdf_parser/urdf_parser.h>
+#include <octomap/OcTree.h>
 #include <geometric_shapes/shape_operations.h>
 
 #include <gtest/gtest.h>
@@ -334,6 +335,104 @@ TEST_F(FclCollisionDetectionTester, AttachedBodyTester)
   ASSERT_TRUE(res.collision);
 }
 
+TEST_F(FclCollisionDetectionTester, AttachedBodyMovesWithState)
+{
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  Eigen::Isometry3d pos1 = Eigen::Isometry3d::Identity();
+  pos1.translation().x() = 5.0;
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+  robot_state.update();
+
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)));
+  EigenSTL::vector_Isometry3d poses(1, Eigen::Isometry3d::Identity());
+  std::vector<std::string> touch_links(1, "r_gripper_palm_link");
+  robot_state.attachBody("box", shapes, poses, touch_links, "r_gripper_palm_link");
+
+  Eigen::Isometry3d pos2 = Eigen::Isometry3d::Identity();
+  pos2.translation().x() = 5.0;
+  pos2.translation().z() = 2.0;
+  cworld_->getWorld()->addToObject("coll", shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)), pos2);
+  acm_->setEntry("coll", robot_model_->getLinkModelNames(), true);
+  acm_->setEntry("coll", "box", false);
+
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  // the attached body is created once and then only moved along with the state
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos2);
+  robot_state.update();
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  robot_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+  robot_state.update();
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  // attaching a different body to the state invalidates the cached one
+  robot_state.clearAttachedBody("box");
+  shapes[0].reset(new shapes::Box(.1, .1, 5.0));
+  robot_state.attachBody("box", shapes, poses, touch_links, "r_gripper_palm_link");
+  robot_state.update();
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+}
+
+TEST_F(FclCollisionDetectionTester, AttachedBodySharedByStateCopies)
+{
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  collision_detection::CollisionResult res;
+
+  Eigen::Isometry3d pos = Eigen::Isometry3d::Identity();
+  pos.translation().x() = 5.0;
+  auto original = std::make_shared<robot_state::RobotState>(robot_model_);
+  original->setToDefaultValues();
+  original->updateStateWithLinkAt("r_gripper_palm_link", pos);
+  original->update();
+
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)));
+  EigenSTL::vector_Isometry3d poses(1, Eigen::Isometry3d::Identity());
+  std::vector<std::string> touch_links = { "r_gripper_palm_link", "r_gripper_motor_accelerometer_link" };
+  original->attachBody("box", shapes, poses, touch_links, "r_gripper_palm_link");
+  original->update();
+  crobot_->checkSelfCollision(req, res, *original, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  // the copy has its own attached body with the same shapes; the FCL objects are shared, but they must refer to
+  // the body of the copy once the original is gone
+  robot_state::RobotState copy(*original);
+  original.reset();
+  res.clear();
+  crobot_->checkSelfCollision(req, res, copy, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  pos.translation().x() = 5.01;
+  cworld_->getWorld()->addToObject("coll", shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)), pos);
+  acm_->setEntry("coll", robot_model_->getLinkModelNames(), true);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, copy, *acm_);
+  ASSERT_TRUE(res.collision);
+  ASSERT_EQ(res.contacts.size(), 1u);
+  EXPECT_EQ(res.contacts.begin()->first, std::make_pair(std::string("box"), std::string("coll")));
+
+  // a state checked against a copy of itself gets separate objects for its attached body
+  robot_state::RobotState other(copy);
+  acm_->setEntry(robot_model_->getLinkModelNames(), robot_model_->getLinkModelNames(), true);
+  req.max_contacts = 1000;
+  res.clear();
+  crobot_->checkOtherCollision(req, res, copy, *crobot_, other, *acm_);
+  EXPECT_TRUE(res.collision);
+  EXPECT_EQ(res.contacts.count(std::make_pair(std::string("box"), std::string("box"))), 1u);
+}
+
 TEST_F(FclCollisionDetectionTester, DiffSceneTester)
 {
   robot_state::RobotState robot_state(robot_model_);
@@ -493,6 +592,314 @@ TEST_F(FclCollisionDetectionTester, MoveMesh)
   }
 }
 
+TEST_F(FclCollisionDetectionTester, MoveObjectUpdatesCollision)
+{
+  robot_state::RobotState robot_state1(robot_model_);
+  robot_state1.setToDefaultValues();
+  robot_state1.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.5, 0.5, 0.5));
+  Eigen::Isometry3d far_pose = Eigen::Translation3d(5.0, 0.0, 0.0) * Eigen::Quaterniond::Identity();
+  Eigen::Isometry3d base_pose = Eigen::Translation3d(0.0, 0.0, 0.3) * Eigen::Quaterniond::Identity();
+  cworld_->getWorld()->addToObject("box", box, far_pose);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  ASSERT_FALSE(res.collision);
+
+  // moving the object has to update its position in the broadphase
+  cworld_->getWorld()->moveShapeInObject("box", box, base_pose);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  ASSERT_TRUE(res.collision);
+
+  // a copy shares the FCL objects with this world; moving the object in the copy must not affect this world
+  collision_detection::WorldPtr world_copy(new collision_detection::World(*cworld_->getWorld()));
+  DefaultCWorldType cworld_copy(dynamic_cast<const DefaultCWorldType&>(*cworld_), world_copy);
+  world_copy->moveShapeInObject("box", box, far_pose);
+
+  res.clear();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  cworld_->getWorld()->moveObject("box", far_pose * base_pose.inverse());
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
+// exposes the robot's bounding box, so it can be compared to the bounding boxes of the robot's FCL objects
+class CollisionRobotBoundsTester : public DefaultCRobotType
+{
+public:
+  using DefaultCRobotType::DefaultCRobotType;
+  using DefaultCRobotType::computeAABB;
+  using DefaultCRobotType::constructFCLObject;
+};
+
+TEST_F(FclCollisionDetectionTester, RobotAABBContainsAllObjects)
+{
+  CollisionRobotBoundsTester crobot(robot_model_);
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToRandomPositions();
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(.1, .1, 2.0)));
+  EigenSTL::vector_Isometry3d poses(1, Eigen::Isometry3d::Identity());
+  std::vector<std::string> touch_links(1, "r_gripper_palm_link");
+  robot_state.attachBody("box", shapes, poses, touch_links, "r_gripper_palm_link");
+  robot_state.update();
+
+  Eigen::AlignedBox3d aabb;
+  crobot.computeAABB(robot_state, aabb);
+  aabb.extend(aabb.min() - Eigen::Vector3d::Constant(1e-9));
+  aabb.extend(aabb.max() + Eigen::Vector3d::Constant(1e-9));
+
+  collision_detection::FCLObject fcl_obj;
+  crobot.constructFCLObject(robot_state, fcl_obj);
+  ASSERT_FALSE(fcl_obj.collision_objects_.empty());
+  for (const collision_detection::FCLCollisionObjectPtr& obj : fcl_obj.collision_objects_)
+  {
+    const auto& obj_aabb = obj->getAABB();
+    EXPECT_TRUE(aabb.contains(Eigen::Vector3d(obj_aabb.min_[0], obj_aabb.min_[1], obj_aabb.min_[2])));
+    EXPECT_TRUE(aabb.contains(Eigen::Vector3d(obj_aabb.max_[0], obj_aabb.max_[1], obj_aabb.max_[2])));
+  }
+}
+
+TEST_F(FclCollisionDetectionTester, CopiedWorldSharesBroadphase)
+{
+  robot_state::RobotState robot_state1(robot_model_);
+  robot_state1.setToDefaultValues();
+  robot_state1.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.5, 0.5, 0.5));
+  Eigen::Isometry3d far_pose = Eigen::Translation3d(5.0, 0.0, 0.0) * Eigen::Quaterniond::Identity();
+  Eigen::Isometry3d base_pose = Eigen::Translation3d(0.0, 0.0, 0.3) * Eigen::Quaterniond::Identity();
+  cworld_->getWorld()->addToObject("box", box, base_pose);
+  cworld_->getWorld()->addToObject("far_box", box, far_pose);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  collision_detection::WorldPtr world_copy(new collision_detection::World(*cworld_->getWorld()));
+  DefaultCWorldType cworld_copy(dynamic_cast<const DefaultCWorldType&>(*cworld_), world_copy);
+  cworld_copy.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  ASSERT_TRUE(res.collision);
+
+  // objects removed from the copy are ignored in the shared broadphase structure
+  world_copy->removeObject("box");
+  res.clear();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  // changes to the original after the copy was made do not affect the copy
+  cworld_->getWorld()->moveShapeInObject("box", box, far_pose);
+  world_copy->addToObject("box2", box, base_pose);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  // a copy of the copy sees the objects added on top of the shared structure as well
+  collision_detection::WorldPtr world_copy2(new collision_detection::World(*world_copy));
+  DefaultCWorldType cworld_copy2(cworld_copy, world_copy2);
+  res.clear();
+  cworld_copy2.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+  world_copy2->removeObject("box2");
+  res.clear();
+  cworld_copy2.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+  res.clear();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+}
+
+TEST_F(FclCollisionDetectionTester, ReusedObjectIndex)
+{
+  robot_state::RobotState robot_state1(robot_model_);
+  robot_state1.setToDefaultValues();
+  robot_state1.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.5, 0.5, 0.5));
+  Eigen::Isometry3d far_pose = Eigen::Translation3d(5.0, 0.0, 0.0) * Eigen::Quaterniond::Identity();
+  Eigen::Isometry3d base_pose = Eigen::Translation3d(0.0, 0.0, 0.3) * Eigen::Quaterniond::Identity();
+  cworld_->getWorld()->addToObject("box", box, base_pose);
+  cworld_->getWorld()->addToObject("far_box", box, far_pose);
+  std::size_t index = cworld_->getWorld()->getObject("box")->index_;
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  collision_detection::CollisionResult res;
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  ASSERT_TRUE(res.collision);
+
+  // a new object gets the index of the removed one, but none of its FCL objects
+  cworld_->getWorld()->removeObject("box");
+  cworld_->getWorld()->addToObject("new_box", box, far_pose);
+  ASSERT_EQ(index, cworld_->getWorld()->getObject("new_box")->index_);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  cworld_->getWorld()->moveShapeInObject("new_box", box, base_pose);
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state1, *acm_);
+  EXPECT_TRUE(res.collision);
+  for (const auto& contact : res.contacts)
+    EXPECT_TRUE(contact.first.first == "new_box" || contact.first.second == "new_box");
+}
+
+TEST_F(FclCollisionDetectionTester, RepeatedDistanceQueries)
+{
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.2, 0.2, 0.2));
+  for (int i = 0; i < 4; ++i)
+  {
+    Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+    pose.translation() = Eigen::Vector3d(1.5 + 0.3 * i, 0.5 * i - 0.75, 0.5 + 0.2 * i);
+    cworld_->getWorld()->addToObject("box" + std::to_string(i), box, pose);
+  }
+
+  collision_detection::DistanceRequest req;
+  req.enable_nearest_points = true;
+  const std::vector<std::string>& joints = robot_model_->getJointModelGroup("right_arm")->getVariableNames();
+  for (int step = 0; step < 5; ++step)
+  {
+    robot_state.setVariablePosition(joints[0], -0.5 + 0.25 * step);
+    robot_state.setVariablePosition(joints[1], 0.1 * step);
+    robot_state.update();
+
+    // queries that start from the closest pair of the previous one find the same result as a new world
+    collision_detection::DistanceResult res;
+    cworld_->distanceRobot(req, res, *crobot_, robot_state);
+    DefaultCWorldType fresh_world(cworld_->getWorld());
+    collision_detection::DistanceResult fresh_res;
+    fresh_world.distanceRobot(req, fresh_res, *crobot_, robot_state);
+
+    EXPECT_DOUBLE_EQ(fresh_res.minimum_distance.distance, res.minimum_distance.distance);
+    EXPECT_EQ(fresh_res.minimum_distance.link_names[0], res.minimum_distance.link_names[0]);
+    EXPECT_EQ(fresh_res.minimum_distance.link_names[1], res.minimum_distance.link_names[1]);
+  }
+}
+
+TEST_F(FclCollisionDetectionTester, RepeatedSelfDistanceQueries)
+{
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+
+  // only the distances between the two arms are of interest
+  acm_->setEntry(robot_model_->getJointModelGroup("right_arm")->getLinkModelNamesWithCollisionGeometry(),
+                 robot_model_->getJointModelGroup("left_arm")->getLinkModelNamesWithCollisionGeometry(), false);
+
+  collision_detection::DistanceRequest req;
+  req.acm = acm_.get();
+  req.enable_nearest_points = true;
+  const std::vector<std::string>& joints = robot_model_->getJointModelGroup("right_arm")->getVariableNames();
+  for (int step = 0; step < 10; ++step)
+  {
+    // swing the right arm towards the left one in small steps
+    robot_state.setVariablePosition(joints[0], 0.1 * step);
+    robot_state.update();
+
+    // skipping the pairs that cannot have come close since the previous query does not change the result
+    collision_detection::DistanceResult res;
+    crobot_->distanceSelf(req, res, robot_state);
+    DefaultCRobotType fresh_robot(robot_model_);
+    collision_detection::DistanceResult fresh_res;
+    fresh_robot.distanceSelf(req, fresh_res, robot_state);
+
+    EXPECT_DOUBLE_EQ(fresh_res.minimum_distance.distance, res.minimum_distance.distance);
+  }
+}
+
+TEST_F(FclCollisionDetectionTester, SignedDistanceOfConvexShapes)
+{
+  DefaultCWorldType other_world;
+  cworld_->getWorld()->addToObject("sphere", shapes::ShapeConstPtr(new shapes::Sphere(0.5)),
+                                   Eigen::Isometry3d::Identity());
+  Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+  pose.translation().x() = 0.9;
+  other_world.getWorld()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(1, 1, 1)), pose);
+
+  collision_detection::DistanceRequest req;
+  req.enable_signed_distance = true;
+  req.enable_nearest_points = true;
+  collision_detection::DistanceResult res;
+  cworld_->distanceWorld(req, res, other_world);
+
+  // the sphere reaches 0.1 into the box
+  EXPECT_TRUE(res.collision);
+  EXPECT_NEAR(-0.1, res.minimum_distance.distance, 1e-3);
+  // the normal points from the first to the second object
+  double direction = res.minimum_distance.link_names[0] == "sphere" ? 1.0 : -1.0;
+  EXPECT_GT(direction * res.minimum_distance.normal.x(), 0.9);
+}
+
+TEST(OctreeOccupancyIndex, MayBeOccupied)
+{
+  octomap::OcTree octree(0.1);
+  octree.updateNode(octomap::point3d(1.05, 0.05, 0.05), true);
+  Eigen::Isometry3d pose = Eigen::Translation3d(0.0, 0.0, 1.0) * Eigen::Quaterniond::Identity();
+  collision_detection::OctreeOccupancyIndex index(octree, pose);
+  EXPECT_EQ(index.getOccupiedCellCount(), 1u);
+
+  EXPECT_TRUE(index.mayBeOccupied(Eigen::Vector3d(1.0, 0.0, 1.0), Eigen::Vector3d(1.1, 0.1, 1.1)));
+  EXPECT_TRUE(index.mayBeOccupied(Eigen::Vector3d(-1.0, -1.0, 0.0), Eigen::Vector3d(2.0, 1.0, 2.0)));
+  EXPECT_FALSE(index.mayBeOccupied(Eigen::Vector3d(1.0, 0.0, 0.0), Eigen::Vector3d(1.1, 0.1, 0.1)));
+  EXPECT_FALSE(index.mayBeOccupied(Eigen::Vector3d(-1.0, -1.0, -1.0), Eigen::Vector3d(0.0, 0.0, 0.0)));
+}
+
+TEST_F(FclCollisionDetectionTester, OctomapCollision)
+{
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  acm_.reset(new collision_detection::AllowedCollisionMatrix(robot_model_->getLinkModelNames(), true));
+  acm_->setEntry("map", robot_model_->getLinkModelNames(), false);
+
+  // a map with occupied space far away from the robot
+  std::shared_ptr<octomap::OcTree> octree(new octomap::OcTree(0.05));
+  octree->updateNode(octomap::point3d(3.0, 0.0, 0.5), true);
+  cworld_->getWorld()->addToObject("map", shapes::ShapeConstPtr(new shapes::OcTree(octree)),
+                                   Eigen::Isometry3d::Identity());
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  // a layer of occupied space cutting through the base of the robot
+  octree.reset(new octomap::OcTree(0.05));
+  octree->updateNode(octomap::point3d(3.0, 0.0, 0.5), true);
+  for (double x = -0.6; x < 0.6; x += 0.05)
+    for (double y = -0.6; y < 0.6; y += 0.05)
+      octree->updateNode(octomap::point3d(x, y, 0.15), true);
+  cworld_->getWorld()->removeObject("map");
+  cworld_->getWorld()->addToObject("map", shapes::ShapeConstPtr(new shapes::OcTree(octree)),
+                                   Eigen::Isometry3d::Identity());
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  // moving the map updates its index
+  cworld_->getWorld()->moveShapeInObject("map", cworld_->getWorld()->getObject("map")->shapes_[0],
+                                         Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.0, 5.0)));
+  res.clear();
+  cworld_->checkRobotCollision(req, res, *crobot_, robot_state, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
 TEST_F(FclCollisionDetectionTester, TestChangingShapeSize)
 {
   robot_state::RobotState robot_state1(robot_model_);
@@ -42,6 +42,7 @@
 #include <kdl/chainidsolver_recursive_newton_euler.hpp>
 
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/Wrench.h>
 
@@ -115,6 +116,31 @@ public:
   bool getPayloadTorques(const std::vector<double>& joint_angles, double payload,
                          std::vector<double>& joint_torques) const;
 
+  /**
+   * @brief Get the torques for every waypoint of a trajectory. Positions, velocities and accelerations
+   * are read directly from the waypoints (missing velocities or accelerations are taken as zero).
+   * Internal buffers are allocated once per thread, not once per waypoint.
+   * @param trajectory The trajectory to evaluate; its waypoints must contain the joints of this group
+   * @param payload The payload (in kg) attached to the origin of the last link of this group
+   * @param torques Filled with one vector of torques (of size = number of joints in the group) per waypoint
+   * @param num_threads The number of threads the waypoints are split across (0 uses all available cores)
+   * @return False if the solver was not initialized properly or the computation failed for any waypoint
+   */
+  bool getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                            std::vector<std::vector<double> >& torques, unsigned int num_threads = 1) const;
+
+  /**
+   * @brief Get the maximum payload (in kg) for every waypoint of a trajectory. This is the same quantity as
+   * computed by getMaxPayload(), evaluated for the positions of each waypoint.
+   * @param trajectory The trajectory to evaluate; its waypoints must contain the joints of this group
+   * @param payloads Filled with the maximum payload for each waypoint
+   * @param joint_saturated Filled with the index of the first saturated joint for each waypoint
+   * @param num_threads The number of threads the waypoints are split across (0 uses all available cores)
+   * @return False if the solver was not initialized properly or the computation failed for any waypoint
+   */
+  bool getTrajectoryMaxPayload(const robot_trajectory::RobotTrajectory& trajectory, std::vector<double>& payloads,
+                               std::vector<unsigned int>& joint_saturated, unsigned int num_threads = 1) const;
+
   /**
    * @brief Get maximum torques for this group
    * @return Vector of max torques
@@ -136,6 +162,18 @@ public:
   }
 
 private:
+  struct Workspace;
+
+  /** \brief Compute the torques for waypoints [begin, end) of \e trajectory using the buffers in \e workspace */
+  bool computeTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                                std::size_t begin, std::size_t end, Workspace& workspace,
+                                std::vector<std::vector<double> >& torques) const;
+
+  /** \brief Compute the maximum payload for waypoints [begin, end) of \e trajectory using the buffers in \e workspace */
+  bool computeTrajectoryMaxPayload(const robot_trajectory::RobotTrajectory& trajectory, std::size_t begin,
+                                   std::size_t end, Workspace& workspace, std::vector<double>& payloads,
+                                   std::vector<unsigned int>& joint_saturated) const;
+
   std::shared_ptr<KDL::ChainIdSolver_RNE> chain_id_solver_;  // KDL chain inverse dynamics
   KDL::Chain kdl_chain_;                                     // KDL chain
 
@@ -148,7 +186,8 @@ private:
   unsigned int num_joints_, num_segments_;  // number of joints in group, number of segments in group
   std::vector<double> max_torques_;         // vector of max torques
 
-  double gravity_;  // Norm of the gravity vector passed in initialize()
+  double gravity_;              // Norm of the gravity vector passed in initialize()
+  KDL::Vector gravity_vector_;  // Gravity vector passed in initialize()
 };
 }
 #endif
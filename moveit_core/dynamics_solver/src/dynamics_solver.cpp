@@ -35,6 +35,7 @@
 /* Author: Sachin Chitta */
 
 #include <moveit/dynamics_solver/dynamics_solver.h>
+#include <moveit/utils/parallel_chunks.h>
 
 // KDL
 #include <kdl/jntarray.hpp>
@@ -62,8 +63,41 @@ inline geometry_msgs::Vector3 transformVector(const Eigen::Isometry3d& transform
 
   return result;
 }
+
+inline KDL::Vector transformVector(const Eigen::Isometry3d& transform, const KDL::Vector& vector)
+{
+  Eigen::Vector3d p = transform.rotation() * Eigen::Vector3d(vector.x(), vector.y(), vector.z());
+  return KDL::Vector(p.x(), p.y(), p.z());
+}
 }  // namespace
 
+/** \brief Buffers for evaluating many waypoints without allocating. Each thread owns one workspace,
+ * as KDL solvers keep internal state and cannot be shared. */
+struct DynamicsSolver::Workspace
+{
+  Workspace(const robot_model::RobotModelConstPtr& robot_model, const KDL::Chain& chain, const KDL::Vector& gravity,
+            unsigned int num_joints, unsigned int num_segments)
+    : state(robot_model)
+    , solver(chain, gravity)
+    , angles(num_joints)
+    , velocities(num_joints)
+    , accelerations(num_joints)
+    , torques(num_joints)
+    , zero_torques(num_joints)
+    , wrenches(num_segments)
+    , values(num_joints)
+  {
+    state.setToDefaultValues();
+  }
+
+  /** \brief Transforms of the base and tip links are computed here, as waypoints may not be up to date */
+  robot_state::RobotState state;
+  KDL::ChainIdSolver_RNE solver;
+  KDL::JntArray angles, velocities, accelerations, torques, zero_torques;
+  KDL::Wrenches wrenches;
+  std::vector<double> values;
+};
+
 DynamicsSolver::DynamicsSolver(const robot_model::RobotModelConstPtr& robot_model, const std::string& group_name,
                                const geometry_msgs::Vector3& gravity_vector)
 {
@@ -136,6 +170,7 @@ DynamicsSolver::DynamicsSolver(const robot_model::RobotModelConstPtr& robot_mode
   KDL::Vector gravity(gravity_vector.x, gravity_vector.y,
                       gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
   gravity_ = gravity.Norm();
+  gravity_vector_ = gravity;
   ROS_DEBUG_NAMED("dynamics_solver", "Gravity norm set to %f", gravity_);
 
   chain_id_solver_.reset(new KDL::ChainIdSolver_RNE(kdl_chain_, gravity));
@@ -312,6 +347,178 @@ bool DynamicsSolver::getPayloadTorques(const std::vector<double>& joint_angles,
   return getTorques(joint_angles, joint_velocities, joint_accelerations, wrenches, joint_torques);
 }
 
+bool DynamicsSolver::getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                                          std::vector<std::vector<double> >& torques, unsigned int num_threads) const
+{
+  if (!joint_model_group_)
+  {
+    ROS_DEBUG_NAMED("dynamics_solver", "Did not construct DynamicsSolver object properly. "
+                                       "Check error logs.");
+    return false;
+  }
+
+  torques.resize(trajectory.getWayPointCount());
+  for (std::vector<double>& waypoint_torques : torques)
+    waypoint_torques.resize(num_joints_);
+
+  // every chunk writes to a disjoint range of the output, using its own workspace
+  return moveit::core::runChunked(trajectory.getWayPointCount(), num_threads, [&](std::size_t begin, std::size_t end) {
+    Workspace workspace(robot_model_, kdl_chain_, gravity_vector_, num_joints_, num_segments_);
+    return computeTrajectoryTorques(trajectory, payload, begin, end, workspace, torques);
+  });
+}
+
+bool DynamicsSolver::getTrajectoryMaxPayload(const robot_trajectory::RobotTrajectory& trajectory,
+                                             std::vector<double>& payloads, std::vector<unsigned int>& joint_saturated,
+                                             unsigned int num_threads) const
+{
+  if (!joint_model_group_)
+  {
+    ROS_DEBUG_NAMED("dynamics_solver", "Did not construct DynamicsSolver object properly. "
+                                       "Check error logs.");
+    return false;
+  }
+
+  payloads.resize(trajectory.getWayPointCount());
+  joint_saturated.resize(trajectory.getWayPointCount());
+
+  return moveit::core::runChunked(trajectory.getWayPointCount(), num_threads, [&](std::size_t begin, std::size_t end) {
+    Workspace workspace(robot_model_, kdl_chain_, gravity_vector_, num_joints_, num_segments_);
+    return computeTrajectoryMaxPayload(trajectory, begin, end, workspace, payloads, joint_saturated);
+  });
+}
+
+bool DynamicsSolver::computeTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory, double payload,
+                                              std::size_t begin, std::size_t end, Workspace& workspace,
+                                              std::vector<std::vector<double> >& torques) const
+{
+  const robot_model::LinkModel* base_link = robot_model_->getLinkModel(base_name_);
+  const robot_model::LinkModel* tip_link = robot_model_->getLinkModel(tip_name_);
+  const KDL::Vector payload_force(0.0, 0.0, payload * gravity_);
+
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const robot_state::RobotState& waypoint = trajectory.getWayPoint(i);
+
+    waypoint.copyJointGroupPositions(joint_model_group_, &workspace.values[0]);
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      workspace.angles(j) = workspace.values[j];
+    if (payload != 0.0)
+    {
+      workspace.state.setJointGroupPositions(joint_model_group_, workspace.values);
+      workspace.state.update();
+    }
+
+    if (waypoint.hasVelocities())
+    {
+      waypoint.copyJointGroupVelocities(joint_model_group_, &workspace.values[0]);
+      for (unsigned int j = 0; j < num_joints_; ++j)
+        workspace.velocities(j) = workspace.values[j];
+    }
+    else
+      SetToZero(workspace.velocities);
+
+    if (waypoint.hasAccelerations())
+    {
+      waypoint.copyJointGroupAccelerations(joint_model_group_, &workspace.values[0]);
+      for (unsigned int j = 0; j < num_joints_; ++j)
+        workspace.accelerations(j) = workspace.values[j];
+    }
+    else
+      SetToZero(workspace.accelerations);
+
+    if (payload != 0.0)
+    {
+      const Eigen::Isometry3d transform = workspace.state.getGlobalLinkTransform(tip_link).inverse() *
+                                          workspace.state.getGlobalLinkTransform(base_link);
+      workspace.wrenches.back() = KDL::Wrench(transformVector(transform, payload_force), KDL::Vector::Zero());
+    }
+
+    if (workspace.solver.CartToJnt(workspace.angles, workspace.velocities, workspace.accelerations,
+                                   workspace.wrenches, workspace.torques) < 0)
+    {
+      ROS_ERROR_NAMED("dynamics_solver", "Something went wrong computing torques for waypoint %zu", i);
+      return false;
+    }
+
+    std::vector<double>& waypoint_torques = torques[i];
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      waypoint_torques[j] = workspace.torques(j);
+  }
+  return true;
+}
+
+bool DynamicsSolver::computeTrajectoryMaxPayload(const robot_trajectory::RobotTrajectory& trajectory,
+                                                 std::size_t begin, std::size_t end, Workspace& workspace,
+                                                 std::vector<double>& payloads,
+                                                 std::vector<unsigned int>& joint_saturated) const
+{
+  const robot_model::LinkModel* base_link = robot_model_->getLinkModel(base_name_);
+  const robot_model::LinkModel* tip_link = robot_model_->getLinkModel(tip_name_);
+  const KDL::Vector unit_force(0.0, 0.0, 1.0);
+
+  SetToZero(workspace.velocities);
+  SetToZero(workspace.accelerations);
+
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const robot_state::RobotState& waypoint = trajectory.getWayPoint(i);
+    waypoint.copyJointGroupPositions(joint_model_group_, &workspace.values[0]);
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      workspace.angles(j) = workspace.values[j];
+    workspace.state.setJointGroupPositions(joint_model_group_, workspace.values);
+
+    // torques needed to hold the group itself
+    workspace.wrenches.back() = KDL::Wrench::Zero();
+    if (workspace.solver.CartToJnt(workspace.angles, workspace.velocities, workspace.accelerations,
+                                   workspace.wrenches, workspace.zero_torques) < 0)
+    {
+      ROS_ERROR_NAMED("dynamics_solver", "Something went wrong computing torques for waypoint %zu", i);
+      return false;
+    }
+
+    bool saturated = false;
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      if (fabs(workspace.zero_torques(j)) >= max_torques_[j])
+      {
+        payloads[i] = 0.0;
+        joint_saturated[i] = j;
+        saturated = true;
+        break;
+      }
+    if (saturated)
+      continue;
+
+    // torques with a unit force applied at the tip, as in getMaxPayload()
+    workspace.state.update();
+    const Eigen::Isometry3d transform = workspace.state.getGlobalLinkTransform(tip_link).inverse() *
+                                        workspace.state.getGlobalLinkTransform(base_link);
+    workspace.wrenches.back() = KDL::Wrench(transformVector(transform, unit_force), KDL::Vector::Zero());
+    if (workspace.solver.CartToJnt(workspace.angles, workspace.velocities, workspace.accelerations,
+                                   workspace.wrenches, workspace.torques) < 0)
+    {
+      ROS_ERROR_NAMED("dynamics_solver", "Something went wrong computing torques for waypoint %zu", i);
+      return false;
+    }
+
+    double min_payload = std::numeric_limits<double>::max();
+    for (unsigned int j = 0; j < num_joints_; ++j)
+    {
+      const double zero_torque = workspace.zero_torques(j);
+      const double unit_torque = workspace.torques(j) - zero_torque;
+      const double payload_joint =
+          std::max<double>((max_torques_[j] - zero_torque) / unit_torque, (-max_torques_[j] - zero_torque) / unit_torque);
+      if (payload_joint < min_payload)
+      {
+        min_payload = payload_joint;
+        joint_saturated[i] = j;
+      }
+    }
+    payloads[i] = min_payload / gravity_;
+  }
+  return true;
+}
+
 const std::vector<double>& DynamicsSolver::getMaxTorques() const
 {
   return max_torques_;
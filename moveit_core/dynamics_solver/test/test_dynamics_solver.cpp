@@ -0,0 +1,118 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/dynamics_solver/dynamics_solver.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <gtest/gtest.h>
+
+class DynamicsSolverTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("pr2");
+    geometry_msgs::Vector3 gravity;
+    gravity.z = -9.81;
+    solver_.reset(new dynamics_solver::DynamicsSolver(robot_model_, "right_arm", gravity));
+    ASSERT_TRUE(solver_->getGroup());
+
+    // the link transforms of the waypoints are deliberately left out of date
+    robot_state::RobotState state(robot_model_);
+    state.setToDefaultValues();
+    state.update();
+    trajectory_.reset(new robot_trajectory::RobotTrajectory(robot_model_, "right_arm"));
+    for (int i = 0; i < 20; ++i)
+    {
+      state.setToRandomPositions(solver_->getGroup());
+      trajectory_->addSuffixWayPoint(state, 0.1);
+    }
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+  dynamics_solver::DynamicsSolverPtr solver_;
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+};
+
+TEST_F(DynamicsSolverTest, TrajectoryTorquesMatchSingleWaypoints)
+{
+  const double payload = 0.5;
+  for (unsigned int num_threads : { 1, 3 })
+  {
+    std::vector<std::vector<double> > torques;
+    ASSERT_TRUE(solver_->getTrajectoryTorques(*trajectory_, payload, torques, num_threads));
+    ASSERT_EQ(trajectory_->getWayPointCount(), torques.size());
+
+    for (std::size_t i = 0; i < trajectory_->getWayPointCount(); ++i)
+    {
+      std::vector<double> joint_angles;
+      trajectory_->getWayPoint(i).copyJointGroupPositions(solver_->getGroup(), joint_angles);
+      std::vector<double> expected(joint_angles.size());
+      ASSERT_TRUE(solver_->getPayloadTorques(joint_angles, payload, expected));
+
+      ASSERT_EQ(expected.size(), torques[i].size());
+      for (std::size_t j = 0; j < expected.size(); ++j)
+        EXPECT_NEAR(expected[j], torques[i][j], 1e-9) << "waypoint " << i << ", joint " << j;
+    }
+  }
+}
+
+TEST_F(DynamicsSolverTest, TrajectoryMaxPayloadMatchesSingleWaypoints)
+{
+  for (unsigned int num_threads : { 1, 3 })
+  {
+    std::vector<double> payloads;
+    std::vector<unsigned int> joint_saturated;
+    ASSERT_TRUE(solver_->getTrajectoryMaxPayload(*trajectory_, payloads, joint_saturated, num_threads));
+    ASSERT_EQ(trajectory_->getWayPointCount(), payloads.size());
+    ASSERT_EQ(trajectory_->getWayPointCount(), joint_saturated.size());
+
+    for (std::size_t i = 0; i < trajectory_->getWayPointCount(); ++i)
+    {
+      std::vector<double> joint_angles;
+      trajectory_->getWayPoint(i).copyJointGroupPositions(solver_->getGroup(), joint_angles);
+      double payload;
+      unsigned int saturated;
+      ASSERT_TRUE(solver_->getMaxPayload(joint_angles, payload, saturated));
+
+      EXPECT_NEAR(payload, payloads[i], 1e-9) << "waypoint " << i;
+      EXPECT_EQ(saturated, joint_saturated[i]) << "waypoint " << i;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -109,6 +109,38 @@ public:
    */
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const = 0;
 
+  /**
+   * \brief Decide whether the constraint is satisfied in the indicated
+   * state, without computing a distance
+   *
+   * The result is always the same as decide().satisfied, but derived
+   * classes may use cheaper tests when the distance is not needed.
+   *
+   * @param [in] state The kinematic state used for evaluation
+   * @param [in] verbose Whether or not to print output
+   *
+   * @return True if the constraint is satisfied
+   */
+  virtual bool satisfies(const robot_state::RobotState& state, bool verbose = false) const
+  {
+    return decide(state, verbose).satisfied;
+  }
+
+  /**
+   * \brief Check a sequence of states (e.g. the waypoints of a
+   * trajectory) against the constraint
+   *
+   * Entries of \e satisfied that are already false are skipped; the
+   * others are set to false if the corresponding state violates the
+   * constraint. Derived classes may share work between consecutive
+   * states. The result for each state is the same as satisfies().
+   *
+   * @param [in] states The states to test
+   * @param [in,out] satisfied One entry per state
+   */
+  virtual void filterStates(const std::vector<const robot_state::RobotState*>& states,
+                            std::vector<bool>& satisfied) const;
+
   /** \brief This function returns true if this constraint is
       configured and able to decide whether states do meet the
       constraint or not. If this function returns false it means
@@ -247,6 +279,8 @@ public:
   bool equal(const KinematicConstraint& other, double margin) const override;
 
   ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const override;
+  void filterStates(const std::vector<const robot_state::RobotState*>& states,
+                    std::vector<bool>& satisfied) const override;
   bool enabled() const override;
   void clear() override;
   void print(std::ostream& out = std::cout) const override;
@@ -396,6 +430,13 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const override;
+
+  /**
+   * \brief Decide whether the constraint is satisfied, accepting states
+   * whose total rotation error is well within the smallest axis
+   * tolerance without decomposing the error into Euler angles
+   */
+  bool satisfies(const robot_state::RobotState& state, bool verbose = false) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -485,6 +526,8 @@ protected:
   bool mobile_frame_;                           /**< \brief Whether or not the header frame is mobile or fixed */
   double absolute_x_axis_tolerance_, absolute_y_axis_tolerance_,
       absolute_z_axis_tolerance_; /**< \brief Storage for the tolerances */
+  double early_accept_trace_;     /**< \brief States for which the trace of the rotation error matrix exceeds this
+                                     value are within all axis tolerances */
 };
 
 MOVEIT_CLASS_FORWARD(PositionConstraint);
@@ -563,6 +606,8 @@ public:
 
   void clear() override;
   ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const override;
+  void filterStates(const std::vector<const robot_state::RobotState*>& states,
+                    std::vector<bool>& satisfied) const override;
   bool enabled() const override;
   void print(std::ostream& out = std::cout) const override;
 
@@ -832,8 +877,44 @@ protected:
    */
   bool decideContact(const collision_detection::Contact& contact) const;
 
+  /**
+   * \brief Test the visibility cone against bounding spheres of the robot links
+   *
+   * The cone is enclosed in a right circular cone and every link that is not the sensor or target frame is
+   * tested with its bounding sphere, and then with the bounding spheres of its individual shapes.
+   *
+   * @param [in] state The state from which to produce the cone
+   *
+   * @return True if no link can touch the cone. False if the result is ambiguous and mesh collision checking is needed
+   */
+  bool isConeClearOfLinks(const robot_state::RobotState& state) const;
+
+  /**
+   * \brief Decide the constraint by checking the robot links for collision with the mesh of the visibility cone
+   *
+   * This is the exact check decide() falls back to when isConeClearOfLinks() is inconclusive.
+   *
+   * @param [in] state The state from which to produce the cone
+   * @param [in] verbose Whether to print the result of the check
+   *
+   * @return The result of evaluating the constraint
+   */
+  ConstraintEvaluationResult decideWithConeMesh(const robot_state::RobotState& state, bool verbose) const;
+
+  /** \brief Bounding spheres for the collision geometry of a link, expressed in the link frame */
+  struct LinkBoundingSpheres
+  {
+    const robot_model::LinkModel* link_;
+    Eigen::Vector3d center_;            /**< \brief Center of the sphere enclosing all shapes of the link */
+    double radius_;                     /**< \brief Radius of the sphere enclosing all shapes of the link */
+    EigenSTL::vector_Vector3d centers_; /**< \brief Centers of the spheres enclosing each shape */
+    std::vector<double> radii_;         /**< \brief Radii of the spheres enclosing each shape */
+  };
+
   collision_detection::CollisionRobotPtr collision_robot_; /**< \brief A copy of the collision robot maintained for
                                                               collision checking the cone against robot links */
+  std::vector<LinkBoundingSpheres> link_spheres_; /**< \brief Bounding spheres of all links with collision geometry */
+  std::vector<std::size_t> cone_check_links_; /**< \brief Indices in link_spheres_ of links the cone must not touch */
   bool mobile_sensor_frame_;      /**< \brief True if the sensor is a non-fixed frame relative to the transform frame */
   bool mobile_target_frame_;      /**< \brief True if the target is a non-fixed frame relative to the transform frame */
   std::string target_frame_id_;   /**< \brief The target frame id */
@@ -963,6 +1044,37 @@ public:
   ConstraintEvaluationResult decide(const robot_state::RobotState& state,
                                     std::vector<ConstraintEvaluationResult>& results, bool verbose = false) const;
 
+  /**
+   * \brief Determines whether all constraints are satisfied by state,
+   * without computing distances
+   *
+   * Constraints are evaluated cheapest first (joint, orientation,
+   * position, visibility) and evaluation stops at the first violated
+   * constraint. Use this instead of decide() when only the boolean
+   * result is needed, e.g. for state validity checking.
+   *
+   * @param [in] state The state to test
+   * @param [in] verbose Whether or not to make each evaluated constraint give debug output
+   *
+   * @return True if all constraints are satisfied
+   */
+  bool satisfies(const robot_state::RobotState& state, bool verbose = false) const;
+
+  /**
+   * \brief Determines which states of a sequence (e.g. the waypoints
+   * of a trajectory) satisfy all constraints
+   *
+   * Each constraint processes all states at once, which lets it reuse
+   * data between consecutive states. States that already violate a
+   * constraint are not tested against the remaining ones.
+   *
+   * @param [in] states The states to test
+   * @param [out] satisfied One entry per state, true if the state satisfies all constraints
+   *
+   * @return True if all states satisfy all constraints
+   */
+  bool satisfies(const std::vector<const robot_state::RobotState*>& states, std::vector<bool>& satisfied) const;
+
   /**
    * \brief Whether or not another KinematicConstraintSet is equal to
    * this one.
@@ -1057,6 +1169,8 @@ protected:
   robot_model::RobotModelConstPtr robot_model_; /**< \brief The kinematic model used for by the Set */
   std::vector<KinematicConstraintPtr>
       kinematic_constraints_; /**<  \brief Shared pointers to all the member constraints */
+  std::vector<const KinematicConstraint*> evaluation_order_; /**<  \brief The member constraints ordered by
+                                                                estimated evaluation cost, used by satisfies() */
 
   std::vector<moveit_msgs::JointConstraint> joint_constraints_; /**<  \brief Messages corresponding to all internal
                                                                    joint constraints */
@@ -1067,6 +1181,10 @@ protected:
   std::vector<moveit_msgs::VisibilityConstraint> visibility_constraints_;   /**<  \brief Messages corresponding to all
                                                                                internal visibility constraints */
   moveit_msgs::Constraints all_constraints_; /**<  \brief Messages corresponding to all internal constraints */
+
+private:
+  /** \brief Recompute evaluation_order_ after constraints were added */
+  void updateEvaluationOrder();
 };
 }
 
@@ -43,6 +43,7 @@
 #include <boost/math/constants/constants.hpp>
 #include <tf2_eigen/tf2_eigen.h>
 #include <boost/bind.hpp>
+#include <algorithm>
 #include <limits>
 #include <memory>
 
@@ -205,6 +206,14 @@ bool JointConstraint::equal(const KinematicConstraint& other, double margin) con
   return false;
 }
 
+void KinematicConstraint::filterStates(const std::vector<const robot_state::RobotState*>& states,
+                                       std::vector<bool>& satisfied) const
+{
+  for (std::size_t i = 0; i < states.size(); ++i)
+    if (satisfied[i] && !satisfies(*states[i]))
+      satisfied[i] = false;
+}
+
 ConstraintEvaluationResult JointConstraint::decide(const robot_state::RobotState& state, bool verbose) const
 {
   if (!joint_model_)
@@ -237,6 +246,35 @@ ConstraintEvaluationResult JointConstraint::decide(const robot_state::RobotState
   return ConstraintEvaluationResult(result, constraint_weight_ * fabs(dif));
 }
 
+void JointConstraint::filterStates(const std::vector<const robot_state::RobotState*>& states,
+                                   std::vector<bool>& satisfied) const
+{
+  if (!joint_model_)
+    return;
+
+  // same test as decide(), without the distance and logging
+  const double upper = joint_tolerance_above_ + 2.0 * std::numeric_limits<double>::epsilon();
+  const double lower = -joint_tolerance_below_ - 2.0 * std::numeric_limits<double>::epsilon();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    if (!satisfied[i])
+      continue;
+    const double current_joint_position = states[i]->getVariablePosition(joint_variable_index_);
+    double dif;
+    if (joint_is_continuous_)
+    {
+      dif = normalizeAngle(current_joint_position) - joint_position_;
+      if (dif > boost::math::constants::pi<double>())
+        dif = 2.0 * boost::math::constants::pi<double>() - dif;
+      else if (dif < -boost::math::constants::pi<double>())
+        dif += 2.0 * boost::math::constants::pi<double>();
+    }
+    else
+      dif = current_joint_position - joint_position_;
+    satisfied[i] = dif <= upper && dif >= lower;
+  }
+}
+
 bool JointConstraint::enabled() const
 {
   return joint_model_;
@@ -466,6 +504,46 @@ ConstraintEvaluationResult PositionConstraint::decide(const robot_state::RobotSt
   return ConstraintEvaluationResult(false, 0.0);
 }
 
+void PositionConstraint::filterStates(const std::vector<const robot_state::RobotState*>& states,
+                                      std::vector<bool>& satisfied) const
+{
+  if (!link_model_ || constraint_region_.empty())
+    return;
+
+  // for a mobile frame, the regions are cloned once and only moved when the frame moves between states,
+  // instead of cloning them for every state as decide() does
+  std::vector<bodies::BodyPtr> mobile_regions;
+  Eigen::Isometry3d frame_transform;
+  bool frame_transform_set = false;
+  if (mobile_frame_)
+    for (const bodies::BodyPtr& region : constraint_region_)
+      mobile_regions.push_back(region->cloneAt(Eigen::Isometry3d::Identity()));
+  const std::vector<bodies::BodyPtr>& regions = mobile_frame_ ? mobile_regions : constraint_region_;
+
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    if (!satisfied[i])
+      continue;
+    if (mobile_frame_)
+    {
+      const Eigen::Isometry3d& tf = states[i]->getFrameTransform(constraint_frame_id_);
+      if (!frame_transform_set || tf.matrix() != frame_transform.matrix())
+      {
+        frame_transform = tf;
+        frame_transform_set = true;
+        for (std::size_t j = 0; j < regions.size(); ++j)
+          regions[j]->setPose(frame_transform * constraint_region_pose_[j]);
+      }
+    }
+
+    const Eigen::Vector3d pt = states[i]->getGlobalLinkTransform(link_model_) * offset_;
+    bool inside = false;
+    for (std::size_t j = 0; !inside && j < regions.size(); ++j)
+      inside = regions[j]->containsPoint(pt);
+    satisfied[i] = inside;
+  }
+}
+
 void PositionConstraint::print(std::ostream& out) const
 {
   if (enabled())
@@ -553,6 +631,13 @@ bool OrientationConstraint::configure(const moveit_msgs::OrientationConstraint&
   if (absolute_z_axis_tolerance_ < std::numeric_limits<double>::epsilon())
     ROS_WARN_NAMED("kinematic_constraints", "Near-zero value for absolute_z_axis_tolerance");
 
+  // Each (folded) XYZ Euler angle of a rotation is bounded by its total rotation angle, so a rotation angle below
+  // the smallest tolerance implies all axis tolerances are met. The rotation angle follows from the trace of the
+  // error matrix: trace = 1 + 2 cos(angle). A small margin keeps the test clear of rounding at the boundary.
+  double min_tolerance = std::min(std::min(absolute_x_axis_tolerance_, absolute_y_axis_tolerance_),
+                                  absolute_z_axis_tolerance_);
+  early_accept_trace_ = 1.0 + 2.0 * cos(std::min(0.99 * min_tolerance, boost::math::constants::pi<double>()));
+
   return link_model_ != nullptr;
 }
 
@@ -582,6 +667,7 @@ void OrientationConstraint::clear()
   desired_rotation_frame_id_ = "";
   mobile_frame_ = false;
   absolute_z_axis_tolerance_ = absolute_y_axis_tolerance_ = absolute_x_axis_tolerance_ = 0.0;
+  early_accept_trace_ = 3.0;
 }
 
 bool OrientationConstraint::enabled() const
@@ -598,15 +684,14 @@ ConstraintEvaluationResult OrientationConstraint::decide(const robot_state::Robo
   if (mobile_frame_)
   {
     Eigen::Matrix3d tmp = state.getFrameTransform(desired_rotation_frame_id_).rotation() * desired_rotation_matrix_;
-    Eigen::Isometry3d diff(tmp.transpose() * state.getGlobalLinkTransform(link_model_).rotation());
-    xyz = diff.rotation().eulerAngles(0, 1, 2);
+    Eigen::Matrix3d diff = tmp.transpose() * state.getGlobalLinkTransform(link_model_).linear();
+    xyz = diff.eulerAngles(0, 1, 2);
     // 0,1,2 corresponds to XYZ, the convention used in sampling constraints
   }
   else
   {
-    Eigen::Isometry3d diff(desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).rotation());
-    xyz =
-        diff.rotation().eulerAngles(0, 1, 2);  // 0,1,2 corresponds to XYZ, the convention used in sampling constraints
+    Eigen::Matrix3d diff = desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).linear();
+    xyz = diff.eulerAngles(0, 1, 2);  // 0,1,2 corresponds to XYZ, the convention used in sampling constraints
   }
 
   xyz(0) = std::min(fabs(xyz(0)), boost::math::constants::pi<double>() - fabs(xyz(0)));
@@ -631,6 +716,28 @@ ConstraintEvaluationResult OrientationConstraint::decide(const robot_state::Robo
   return ConstraintEvaluationResult(result, constraint_weight_ * (xyz(0) + xyz(1) + xyz(2)));
 }
 
+bool OrientationConstraint::satisfies(const robot_state::RobotState& state, bool verbose) const
+{
+  if (!link_model_)
+    return true;
+
+  if (!verbose)
+  {
+    // trace(A^T B) is the sum of the element-wise products, so the error matrix itself is not needed
+    const Eigen::Matrix3d& actual = state.getGlobalLinkTransform(link_model_).linear();
+    double trace;
+    if (mobile_frame_)
+      trace = (state.getFrameTransform(desired_rotation_frame_id_).linear() * desired_rotation_matrix_)
+                  .cwiseProduct(actual)
+                  .sum();
+    else
+      trace = desired_rotation_matrix_.cwiseProduct(actual).sum();
+    if (trace > early_accept_trace_)
+      return true;
+  }
+  return decide(state, verbose).satisfied;
+}
+
 void OrientationConstraint::print(std::ostream& out) const
 {
   if (link_model_)
@@ -643,10 +750,64 @@ void OrientationConstraint::print(std::ostream& out) const
     out << "No constraint" << std::endl;
 }
 
+// Distance from p to the solid right circular cone with the given apex, unit axis, height and base radius
+static double distanceToSolidCone(const Eigen::Vector3d& apex, const Eigen::Vector3d& axis, double height,
+                                  double radius, const Eigen::Vector3d& p)
+{
+  // by symmetry, this is the distance from (x, y) to the triangle (0, 0), (height, radius), (height, -radius)
+  Eigen::Vector3d d = p - apex;
+  double x = d.dot(axis);
+  double y = (d - x * axis).norm();
+  if (x >= 0.0 && x <= height && y * height <= x * radius)
+    return 0.0;
+
+  // closest point on the slanted side
+  double t = std::min(1.0, std::max(0.0, (x * height + y * radius) / (height * height + radius * radius)));
+  double side = std::hypot(x - t * height, y - t * radius);
+
+  // closest point on the base
+  double base = std::hypot(x - height, y - std::min(y, radius));
+  return std::min(side, base);
+}
+
 VisibilityConstraint::VisibilityConstraint(const robot_model::RobotModelConstPtr& model)
   : KinematicConstraint(model), collision_robot_(new collision_detection::CollisionRobotFCL(model))
 {
   type_ = VISIBILITY_CONSTRAINT;
+
+  // bounding spheres only depend on the model, so they are computed once
+  for (const robot_model::LinkModel* link : model->getLinkModelsWithCollisionGeometry())
+  {
+    LinkBoundingSpheres lbs;
+    lbs.link_ = link;
+    std::vector<bodies::BoundingSphere> spheres;
+    const std::vector<shapes::ShapeConstPtr>& shapes = link->getShapes();
+    const EigenSTL::vector_Isometry3d& origins = link->getCollisionOriginTransforms();
+    for (std::size_t i = 0; i < shapes.size(); ++i)
+    {
+      std::unique_ptr<bodies::Body> body(bodies::createBodyFromShape(shapes[i].get()));
+      bodies::BoundingSphere sphere;
+      if (body)
+      {
+        body->setPose(origins[i]);
+        body->computeBoundingSphere(sphere);
+      }
+      else
+      {
+        // shapes without a body representation can never be ruled out analytically
+        sphere.center = origins[i].translation();
+        sphere.radius = std::numeric_limits<double>::infinity();
+      }
+      spheres.push_back(sphere);
+      lbs.centers_.push_back(sphere.center);
+      lbs.radii_.push_back(sphere.radius);
+    }
+    bodies::BoundingSphere merged;
+    bodies::mergeBoundingSpheres(spheres, merged);
+    lbs.center_ = merged.center;
+    lbs.radius_ = merged.radius;
+    link_spheres_.push_back(lbs);
+  }
 }
 
 void VisibilityConstraint::clear()
@@ -660,6 +821,7 @@ void VisibilityConstraint::clear()
   target_pose_ = Eigen::Isometry3d::Identity();
   cone_sides_ = 0;
   points_.clear();
+  cone_check_links_.clear();
   target_radius_ = -1.0;
   max_view_angle_ = 0.0;
   max_range_angle_ = 0.0;
@@ -738,6 +900,12 @@ bool VisibilityConstraint::configure(const moveit_msgs::VisibilityConstraint& vc
   max_range_angle_ = vc.max_range_angle;
   sensor_view_direction_ = vc.sensor_view_direction;
 
+  // the cone is allowed to touch the sensor and target links (see decideContact())
+  for (std::size_t i = 0; i < link_spheres_.size(); ++i)
+    if (!robot_state::Transforms::sameFrame(link_spheres_[i].link_->getName(), sensor_frame_id_) &&
+        !robot_state::Transforms::sameFrame(link_spheres_[i].link_->getName(), target_frame_id_))
+      cone_check_links_.push_back(i);
+
   return target_radius_ > std::numeric_limits<double>::epsilon();
 }
 
@@ -979,6 +1147,20 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const robot_state::Robot
     }
   }
 
+  if (isConeClearOfLinks(state))
+  {
+    if (verbose)
+      ROS_INFO_NAMED("kinematic_constraints", "Visibility constraint satisfied. The visibility cone is clear of the "
+                                              "bounding spheres of all robot links");
+    return ConstraintEvaluationResult(true, 0.0);
+  }
+
+  return decideWithConeMesh(state, verbose);
+}
+
+ConstraintEvaluationResult VisibilityConstraint::decideWithConeMesh(const robot_state::RobotState& state,
+                                                                    bool verbose) const
+{
   shapes::Mesh* m = getVisibilityCone(state);
   if (!m)
     return ConstraintEvaluationResult(false, 0.0);
@@ -1008,6 +1190,37 @@ ConstraintEvaluationResult VisibilityConstraint::decide(const robot_state::Robot
   return ConstraintEvaluationResult(!res.collision, res.collision ? res.contacts.begin()->second.front().depth : 0.0);
 }
 
+bool VisibilityConstraint::isConeClearOfLinks(const robot_state::RobotState& state) const
+{
+  const Eigen::Isometry3d& sp =
+      mobile_sensor_frame_ ? state.getFrameTransform(sensor_frame_id_) * sensor_pose_ : sensor_pose_;
+  const Eigen::Isometry3d& tp =
+      mobile_target_frame_ ? state.getFrameTransform(target_frame_id_) * target_pose_ : target_pose_;
+
+  // The cone mesh is the convex hull of the sensor origin and a polygon inscribed in the target disc. The disc lies
+  // inside the ball of radius target_radius_ around the target, so the mesh is enclosed by the right circular cone
+  // from the sensor origin that is tangent to that ball and extends past its far side.
+  Eigen::Vector3d axis = tp.translation() - sp.translation();
+  double dist = axis.norm();
+  if (dist <= target_radius_)
+    return false;
+  axis /= dist;
+  double height = dist + target_radius_;
+  double radius = height * target_radius_ / sqrt(dist * dist - target_radius_ * target_radius_);
+
+  for (std::size_t index : cone_check_links_)
+  {
+    const LinkBoundingSpheres& lbs = link_spheres_[index];
+    const Eigen::Isometry3d& link_pose = state.getGlobalLinkTransform(lbs.link_);
+    if (distanceToSolidCone(sp.translation(), axis, height, radius, link_pose * lbs.center_) > lbs.radius_)
+      continue;
+    for (std::size_t i = 0; i < lbs.radii_.size(); ++i)
+      if (distanceToSolidCone(sp.translation(), axis, height, radius, link_pose * lbs.centers_[i]) <= lbs.radii_[i])
+        return false;
+  }
+  return true;
+}
+
 bool VisibilityConstraint::decideContact(const collision_detection::Contact& contact) const
 {
   if (contact.body_type_1 == collision_detection::BodyTypes::ROBOT_ATTACHED ||
@@ -1048,6 +1261,7 @@ void KinematicConstraintSet::clear()
 {
   all_constraints_ = moveit_msgs::Constraints();
   kinematic_constraints_.clear();
+  evaluation_order_.clear();
   joint_constraints_.clear();
   position_constraints_.clear();
   orientation_constraints_.clear();
@@ -1066,6 +1280,7 @@ bool KinematicConstraintSet::add(const std::vector<moveit_msgs::JointConstraint>
     joint_constraints_.push_back(joint_constraint);
     all_constraints_.joint_constraints.push_back(joint_constraint);
   }
+  updateEvaluationOrder();
   return result;
 }
 
@@ -1082,6 +1297,7 @@ bool KinematicConstraintSet::add(const std::vector<moveit_msgs::PositionConstrai
     position_constraints_.push_back(position_constraint);
     all_constraints_.position_constraints.push_back(position_constraint);
   }
+  updateEvaluationOrder();
   return result;
 }
 
@@ -1098,6 +1314,7 @@ bool KinematicConstraintSet::add(const std::vector<moveit_msgs::OrientationConst
     orientation_constraints_.push_back(orientation_constraint);
     all_constraints_.orientation_constraints.push_back(orientation_constraint);
   }
+  updateEvaluationOrder();
   return result;
 }
 
@@ -1114,6 +1331,7 @@ bool KinematicConstraintSet::add(const std::vector<moveit_msgs::VisibilityConstr
     visibility_constraints_.push_back(visibility_constraint);
     all_constraints_.visibility_constraints.push_back(visibility_constraint);
   }
+  updateEvaluationOrder();
   return result;
 }
 
@@ -1155,6 +1373,55 @@ ConstraintEvaluationResult KinematicConstraintSet::decide(const robot_state::Rob
   return result;
 }
 
+bool KinematicConstraintSet::satisfies(const robot_state::RobotState& state, bool verbose) const
+{
+  for (const KinematicConstraint* kinematic_constraint : evaluation_order_)
+    if (!kinematic_constraint->satisfies(state, verbose))
+      return false;
+  return true;
+}
+
+bool KinematicConstraintSet::satisfies(const std::vector<const robot_state::RobotState*>& states,
+                                       std::vector<bool>& satisfied) const
+{
+  satisfied.assign(states.size(), true);
+  for (const KinematicConstraint* kinematic_constraint : evaluation_order_)
+    kinematic_constraint->filterStates(states, satisfied);
+  return std::find(satisfied.begin(), satisfied.end(), false) == satisfied.end();
+}
+
+// Relative cost of evaluating a constraint: joint constraints read a single variable, orientation constraints
+// compare a rotation, position constraints test containment in bodies and visibility constraints may need a
+// collision check
+static unsigned int estimateEvaluationCost(const KinematicConstraint& constraint)
+{
+  switch (constraint.getType())
+  {
+    case KinematicConstraint::JOINT_CONSTRAINT:
+      return 0;
+    case KinematicConstraint::ORIENTATION_CONSTRAINT:
+      return 1;
+    case KinematicConstraint::POSITION_CONSTRAINT:
+      return 2;
+    case KinematicConstraint::VISIBILITY_CONSTRAINT:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+void KinematicConstraintSet::updateEvaluationOrder()
+{
+  evaluation_order_.clear();
+  evaluation_order_.reserve(kinematic_constraints_.size());
+  for (const KinematicConstraintPtr& kinematic_constraint : kinematic_constraints_)
+    evaluation_order_.push_back(kinematic_constraint.get());
+  std::stable_sort(evaluation_order_.begin(), evaluation_order_.end(),
+                   [](const KinematicConstraint* a, const KinematicConstraint* b) {
+                     return estimateEvaluationCost(*a) < estimateEvaluationCost(*b);
+                   });
+}
+
 void KinematicConstraintSet::print(std::ostream& out) const
 {
   out << kinematic_constraints_.size() << " kinematic constraints" << std::endl;
@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <moveit/utils/benchmark_test_utils.h>
+#include <tf2_eigen/tf2_eigen.h>
+#include <gtest/gtest.h>
+
+using moveit::core::ScopedTimer;
+
+TEST(Timing, orientationConstraint)
+{
+  robot_model::RobotModelPtr model = moveit::core::loadTestingRobotModel("pr2");
+  ASSERT_TRUE(bool(model));
+  const robot_model::JointModelGroup* jmg = model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(jmg);
+  robot_state::Transforms tf(model->getModelFrame());
+
+  robot_state::RobotState default_state(model);
+  default_state.setToDefaultValues();
+  default_state.update();
+
+  kinematic_constraints::OrientationConstraint oc(model);
+  moveit_msgs::OrientationConstraint ocm;
+  ocm.link_name = "r_wrist_roll_link";
+  ocm.header.frame_id = model->getModelFrame();
+  ocm.orientation = tf2::toMsg(Eigen::Quaterniond(default_state.getGlobalLinkTransform(ocm.link_name).linear()));
+  ocm.absolute_x_axis_tolerance = ocm.absolute_y_axis_tolerance = ocm.absolute_z_axis_tolerance = 0.5;
+  ocm.weight = 1.0;
+  ASSERT_TRUE(oc.configure(ocm, tf));
+
+  // precompute states, so only the constraint evaluation is timed
+  const std::size_t count = 1000;
+  std::vector<robot_state::RobotState> states(count, default_state);
+  for (robot_state::RobotState& state : states)
+  {
+    state.setToRandomPositionsNearBy(jmg, default_state, 0.2);
+    state.update();
+  }
+
+  const std::size_t runs = 1000;
+  double gold_standard = 0;
+  std::size_t decided = 0, satisfied = 0;
+  {
+    ScopedTimer t("OrientationConstraint::decide(): ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+      for (const robot_state::RobotState& state : states)
+        decided += oc.decide(state).satisfied;
+  }
+  {
+    ScopedTimer t("OrientationConstraint::satisfies(): ", &gold_standard);
+    for (std::size_t i = 0; i < runs; ++i)
+      for (const robot_state::RobotState& state : states)
+        satisfied += oc.satisfies(state);
+  }
+  EXPECT_EQ(decided, satisfied);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
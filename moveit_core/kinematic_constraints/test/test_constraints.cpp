@@ -654,6 +654,48 @@ TEST_F(LoadPlanningModelsPr2, OrientationConstraintsSimple)
   EXPECT_FALSE(oc.decide(robot_state).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, OrientationConstraintsSatisfies)
+{
+  robot_state::RobotState default_state(robot_model_);
+  default_state.setToDefaultValues();
+  default_state.update();
+  robot_state::RobotState robot_state(default_state);
+  robot_state::Transforms tf(robot_model_->getModelFrame());
+  const robot_model::JointModelGroup* jmg = robot_model_->getJointModelGroup("right_arm");
+  ASSERT_TRUE(jmg);
+
+  // fixed and mobile reference frames
+  for (const std::string& frame : { robot_model_->getModelFrame(), std::string("r_shoulder_pan_link") })
+  {
+    kinematic_constraints::OrientationConstraint oc(robot_model_);
+    moveit_msgs::OrientationConstraint ocm;
+    ocm.link_name = "r_wrist_roll_link";
+    ocm.header.frame_id = frame;
+    Eigen::Isometry3d reference = default_state.getFrameTransform(frame).inverse() *
+                                  default_state.getGlobalLinkTransform(ocm.link_name);
+    ocm.orientation = tf2::toMsg(Eigen::Quaterniond(reference.linear()));
+    ocm.absolute_x_axis_tolerance = 0.3;
+    ocm.absolute_y_axis_tolerance = 0.6;
+    ocm.absolute_z_axis_tolerance = 0.4;
+    ocm.weight = 1.0;
+    EXPECT_TRUE(oc.configure(ocm, tf));
+    EXPECT_TRUE(oc.satisfies(default_state));
+
+    // the boolean evaluation agrees with decide() both inside and outside the tolerances
+    unsigned int satisfied = 0;
+    for (unsigned int i = 0; i < 1000; ++i)
+    {
+      robot_state.setToRandomPositionsNearBy(jmg, default_state, 0.5);
+      robot_state.update();
+      bool expected = oc.decide(robot_state).satisfied;
+      EXPECT_EQ(expected, oc.satisfies(robot_state));
+      satisfied += expected;
+    }
+    EXPECT_GT(satisfied, 0u);
+    EXPECT_LT(satisfied, 1000u);
+  }
+}
+
 TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsSimple)
 {
   robot_state::RobotState robot_state(robot_model_);
@@ -779,6 +821,80 @@ TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsPR2)
   EXPECT_FALSE(vc.decide(robot_state, true).satisfied);
 }
 
+/** \brief Exposes the fast path of VisibilityConstraint::decide() and the mesh collision check it falls back to */
+class VisibilityConstraintInternals : public kinematic_constraints::VisibilityConstraint
+{
+public:
+  using VisibilityConstraint::VisibilityConstraint;
+  using VisibilityConstraint::isConeClearOfLinks;
+  using VisibilityConstraint::decideWithConeMesh;
+};
+
+TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsFastPath)
+{
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  robot_state::Transforms tf(robot_model_->getModelFrame());
+
+  // sensor and target are below the floor, so the cone is clear of the robot
+  VisibilityConstraintInternals vc(robot_model_);
+  moveit_msgs::VisibilityConstraint vcm;
+  vcm.sensor_pose.header.frame_id = "base_footprint";
+  vcm.sensor_pose.pose.position.z = -1.0;
+  vcm.sensor_pose.pose.orientation.y = 1.0;
+  vcm.target_pose.header.frame_id = "base_footprint";
+  vcm.target_pose.pose.position.z = -2.0;
+  vcm.target_pose.pose.orientation.w = 1.0;
+  vcm.target_radius = .2;
+  vcm.cone_sides = 10;
+  vcm.sensor_view_direction = moveit_msgs::VisibilityConstraint::SENSOR_Z;
+  vcm.weight = 1.0;
+  ASSERT_TRUE(vc.configure(vcm, tf));
+  EXPECT_TRUE(vc.isConeClearOfLinks(robot_state));
+  EXPECT_TRUE(vc.decide(robot_state).satisfied);
+  EXPECT_TRUE(vc.decideWithConeMesh(robot_state, false).satisfied);
+
+  // the cone from the head camera to the left gripper is blocked by the right arm
+  vcm = moveit_msgs::VisibilityConstraint();
+  vcm.sensor_pose.header.frame_id = "narrow_stereo_optical_frame";
+  vcm.sensor_pose.pose.position.z = 0.05;
+  vcm.sensor_pose.pose.orientation.w = 1.0;
+  vcm.target_pose.header.frame_id = "l_gripper_r_finger_tip_link";
+  vcm.target_pose.pose.position.z = 0.03;
+  vcm.target_pose.pose.orientation.w = 1.0;
+  vcm.target_radius = .05;
+  vcm.cone_sides = 10;
+  vcm.sensor_view_direction = moveit_msgs::VisibilityConstraint::SENSOR_Z;
+  vcm.weight = 1.0;
+  ASSERT_TRUE(vc.configure(vcm, tf));
+
+  std::map<std::string, double> state_values;
+  state_values["l_shoulder_lift_joint"] = .5;
+  state_values["r_shoulder_pan_joint"] = .5;
+  state_values["r_elbow_flex_joint"] = -1.4;
+  robot_state.setVariablePositions(state_values);
+  robot_state.update();
+  EXPECT_FALSE(vc.isConeClearOfLinks(robot_state));
+  kinematic_constraints::ConstraintEvaluationResult fast = vc.decide(robot_state);
+  kinematic_constraints::ConstraintEvaluationResult mesh = vc.decideWithConeMesh(robot_state, false);
+  EXPECT_FALSE(fast.satisfied);
+  EXPECT_FALSE(mesh.satisfied);
+  EXPECT_EQ(fast.distance, mesh.distance);
+
+  // the fast path never changes the result
+  random_numbers::RandomNumberGenerator rng(0);
+  for (int i = 0; i < 100; ++i)
+  {
+    robot_state.setToRandomPositions(robot_model_->getJointModelGroup("arms"), rng);
+    robot_state.update();
+    fast = vc.decide(robot_state);
+    mesh = vc.decideWithConeMesh(robot_state, false);
+    EXPECT_EQ(fast.satisfied, mesh.satisfied) << "state " << i;
+    EXPECT_EQ(fast.distance, mesh.distance) << "state " << i;
+  }
+}
+
 TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSet)
 {
   robot_state::RobotState robot_state(robot_model_);
@@ -845,6 +961,109 @@ TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSet)
   EXPECT_FALSE(kcs.decide(robot_state).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetSatisfies)
+{
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.update();
+  robot_state::Transforms tf(robot_model_->getModelFrame());
+
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+  // an empty set is always satisfied
+  EXPECT_TRUE(kcs.satisfies(robot_state));
+
+  // an orientation constraint that any state satisfies is added before the joint constraint
+  moveit_msgs::OrientationConstraint ocm;
+  ocm.link_name = "r_wrist_roll_link";
+  ocm.header.frame_id = robot_model_->getModelFrame();
+  ocm.orientation.w = 1.0;
+  ocm.absolute_x_axis_tolerance = M_PI;
+  ocm.absolute_y_axis_tolerance = M_PI;
+  ocm.absolute_z_axis_tolerance = M_PI;
+  ocm.weight = 1.0;
+  std::vector<moveit_msgs::OrientationConstraint> ocv(1, ocm);
+  EXPECT_TRUE(kcs.add(ocv, tf));
+
+  moveit_msgs::JointConstraint jcm;
+  jcm.joint_name = "head_pan_joint";
+  jcm.position = 0.4;
+  jcm.tolerance_above = 0.1;
+  jcm.tolerance_below = 0.05;
+  jcm.weight = 1.0;
+  std::vector<moveit_msgs::JointConstraint> jcv(1, jcm);
+  EXPECT_TRUE(kcs.add(jcv));
+
+  // the boolean evaluation agrees with decide()
+  EXPECT_FALSE(kcs.decide(robot_state).satisfied);
+  EXPECT_FALSE(kcs.satisfies(robot_state));
+
+  std::map<std::string, double> jvals;
+  jvals[jcm.joint_name] = 0.41;
+  robot_state.setVariablePositions(jvals);
+  robot_state.update();
+  EXPECT_TRUE(kcs.decide(robot_state).satisfied);
+  EXPECT_TRUE(kcs.satisfies(robot_state));
+
+  // clearing the set also clears the evaluation order
+  kcs.clear();
+  EXPECT_TRUE(kcs.satisfies(robot_state));
+}
+
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetSatisfiesStates)
+{
+  robot_state::Transforms tf(robot_model_->getModelFrame());
+  kinematic_constraints::KinematicConstraintSet kcs(robot_model_);
+
+  moveit_msgs::JointConstraint jcm;
+  jcm.joint_name = "head_pan_joint";
+  jcm.position = 0.0;
+  jcm.tolerance_above = 1.5;
+  jcm.tolerance_below = 1.5;
+  jcm.weight = 1.0;
+  EXPECT_TRUE(kcs.add(std::vector<moveit_msgs::JointConstraint>(1, jcm)));
+
+  // a position constraint relative to a mobile frame
+  moveit_msgs::PositionConstraint pcm;
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = "r_wrist_roll_link";
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 0.6;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].position.y = 0.6;
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+  EXPECT_TRUE(kcs.add(std::vector<moveit_msgs::PositionConstraint>(1, pcm), tf));
+
+  // random states, each one repeated to also cover consecutive states with the same constraint frame
+  std::vector<robot_state::RobotStatePtr> storage;
+  std::vector<const robot_state::RobotState*> states;
+  for (int i = 0; i < 100; ++i)
+  {
+    robot_state::RobotStatePtr state(new robot_state::RobotState(robot_model_));
+    state->setToRandomPositions();
+    state->update();
+    storage.push_back(state);
+    states.push_back(state.get());
+    states.push_back(state.get());
+  }
+
+  std::vector<bool> satisfied;
+  bool all_satisfied = kcs.satisfies(states, satisfied);
+  ASSERT_EQ(states.size(), satisfied.size());
+  bool expected_all_satisfied = true;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    bool expected = kcs.decide(*states[i]).satisfied;
+    EXPECT_EQ(expected, satisfied[i]);
+    expected_all_satisfied = expected_all_satisfied && expected;
+  }
+  EXPECT_EQ(expected_all_satisfied, all_satisfied);
+  // half of the head_pan_joint range violates the joint constraint
+  EXPECT_FALSE(all_satisfied);
+}
+
 TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetEquality)
 {
   robot_state::RobotState robot_state(robot_model_);
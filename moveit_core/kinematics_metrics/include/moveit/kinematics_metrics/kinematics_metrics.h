@@ -79,6 +79,23 @@ public:
                               const robot_model::JointModelGroup* joint_model_group, double& manipulability_index,
                               bool translation = false) const;
 
+  /**
+   * @brief Get the manipulability for a given group at many joint configurations. The results are identical to
+   * calling getManipulabilityIndex() for each configuration, but Jacobian buffers are reused across configurations
+   * and the configurations can be split across threads.
+   * @param state Complete kinematic state for the robot, used for the variables outside of the group
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param joint_values The group configurations to evaluate (each of size = number of variables in the group)
+   * @param manipulability_indices The computed manipulability = sqrt(det(JJ^T)) for each configuration
+   * @param num_threads The number of threads to use (0 uses all available cores)
+   * @return False if the group is not a chain or a configuration has the wrong size
+   */
+  bool getManipulabilityIndices(const robot_state::RobotState& state,
+                                const robot_model::JointModelGroup* joint_model_group,
+                                const std::vector<std::vector<double> >& joint_values,
+                                std::vector<double>& manipulability_indices, bool translation = false,
+                                unsigned int num_threads = 1) const;
+
   /**
    * @brief Get the (translation) manipulability ellipsoid for a given group at a given joint configuration
    * @param state Complete kinematic state for the robot
@@ -102,6 +119,23 @@ public:
                                   const robot_model::JointModelGroup* joint_model_group, Eigen::MatrixXcd& eigen_values,
                                   Eigen::MatrixXcd& eigen_vectors) const;
 
+  /**
+   * @brief Get the (translation) manipulability ellipsoids for a given group at many joint configurations. The
+   * results are identical to calling getManipulabilityEllipsoid() for each configuration.
+   * @param state Complete kinematic state for the robot, used for the variables outside of the group
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param joint_values The group configurations to evaluate (each of size = number of variables in the group)
+   * @param eigen_values The eigen values for the translation part of JJ^T, for each configuration
+   * @param eigen_vectors The eigen vectors for the translation part of JJ^T, for each configuration
+   * @param num_threads The number of threads to use (0 uses all available cores)
+   * @return False if the group is not a chain or a configuration has the wrong size
+   */
+  bool getManipulabilityEllipsoids(const robot_state::RobotState& state,
+                                   const robot_model::JointModelGroup* joint_model_group,
+                                   const std::vector<std::vector<double> >& joint_values,
+                                   std::vector<Eigen::MatrixXcd>& eigen_values,
+                                   std::vector<Eigen::MatrixXcd>& eigen_vectors, unsigned int num_threads = 1) const;
+
   /**
    * @brief Get the manipulability = sigma_min/sigma_max
    * where sigma_min and sigma_max are the smallest and largest singular values
@@ -140,6 +174,18 @@ protected:
   robot_model::RobotModelConstPtr robot_model_;
 
 private:
+  /** \brief The joints of a group that contribute to the joint limits penalty, with their bounds */
+  struct JointLimitsData
+  {
+    std::vector<const robot_model::JointModel*> joint_models_;
+    std::vector<std::vector<double> > lower_bounds_;
+    std::vector<std::vector<double> > upper_bounds_;
+  };
+
+  /** \brief Collect the joints (and their bounds) considered by getJointLimitsPenalty(), so this lookup can be done
+   * once for many states */
+  JointLimitsData getJointLimitsData(const robot_model::JointModelGroup* joint_model_group) const;
+
   /**
  * @brief Defines a multiplier for the manipulabilty
  * = 1 - exp ( -penalty_multipler_ * product_{i=1}{n} (distance_to_lower_limit *
@@ -155,6 +201,9 @@ private:
   double getJointLimitsPenalty(const robot_state::RobotState& state,
                                const robot_model::JointModelGroup* joint_model_group) const;
 
+  /** \brief Same as above, using joint data precomputed by getJointLimitsData() */
+  double getJointLimitsPenalty(const robot_state::RobotState& state, const JointLimitsData& data) const;
+
   double penalty_multiplier_;
 };
 }
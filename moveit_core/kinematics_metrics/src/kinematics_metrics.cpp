@@ -35,18 +35,88 @@
 /* Author: Sachin Chitta */
 
 #include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <moveit/utils/parallel_chunks.h>
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
 #include <boost/math/constants/constants.hpp>
 
 namespace kinematics_metrics
 {
-double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& state,
-                                                const robot_model::JointModelGroup* joint_model_group) const
+namespace
+{
+// Jacobians of groups with at most this many variables are stored without heap allocation
+static const int MAX_FIXED_SIZE_VARIABLES = 7;
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 6, MAX_FIXED_SIZE_VARIABLES> FixedSizeJacobian;
+
+template <typename Derived>
+double computeManipulabilityIndex(const Eigen::MatrixBase<Derived>& jacobian)
 {
+  typedef typename Derived::PlainObject JacobianType;
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, Derived::MaxRowsAtCompileTime,
+                        Derived::MaxRowsAtCompileTime>
+      SquareType;
+
+  double manipulability_index = 1.0;
+  if (jacobian.cols() < 6)
+  {
+    Eigen::JacobiSVD<JacobianType> svdsolver(jacobian);
+    const typename Eigen::JacobiSVD<JacobianType>::SingularValuesType& singular_values = svdsolver.singularValues();
+    for (unsigned int i = 0; i < singular_values.rows(); ++i)
+    {
+      ROS_DEBUG_NAMED("kinematics_metrics", "Singular value: %d %f", i, singular_values(i));
+      manipulability_index *= singular_values(i);
+    }
+  }
+  else
+  {
+    SquareType matrix = jacobian * jacobian.transpose();
+    manipulability_index = sqrt(matrix.determinant());
+  }
+  return manipulability_index;
+}
+
+template <typename Derived>
+void computeManipulabilityEllipsoid(const Eigen::MatrixBase<Derived>& jacobian, Eigen::MatrixXcd& eigen_values,
+                                    Eigen::MatrixXcd& eigen_vectors)
+{
+  Eigen::Matrix3d matrix = jacobian.topRows(3) * jacobian.topRows(3).transpose();
+  Eigen::EigenSolver<Eigen::Matrix3d> eigensolver(matrix);
+  eigen_values = eigensolver.eigenvalues();
+  eigen_vectors = eigensolver.eigenvectors();
+}
+
+/** \brief Evaluate the manipulability index from a Jacobian, using fixed-size storage for small groups. All paths
+ * (single state and batched) go through here so their results are identical. */
+double manipulabilityIndex(const Eigen::MatrixXd& jacobian, bool translation)
+{
+  if (jacobian.cols() <= MAX_FIXED_SIZE_VARIABLES)
+  {
+    FixedSizeJacobian fixed_jacobian = jacobian;
+    return translation ? computeManipulabilityIndex(fixed_jacobian.topRows(3)) :
+                         computeManipulabilityIndex(fixed_jacobian);
+  }
+  return translation ? computeManipulabilityIndex(jacobian.topRows(3)) : computeManipulabilityIndex(jacobian);
+}
+
+void manipulabilityEllipsoid(const Eigen::MatrixXd& jacobian, Eigen::MatrixXcd& eigen_values,
+                             Eigen::MatrixXcd& eigen_vectors)
+{
+  if (jacobian.cols() <= MAX_FIXED_SIZE_VARIABLES)
+  {
+    FixedSizeJacobian fixed_jacobian = jacobian;
+    computeManipulabilityEllipsoid(fixed_jacobian, eigen_values, eigen_vectors);
+  }
+  else
+    computeManipulabilityEllipsoid(jacobian, eigen_values, eigen_vectors);
+}
+}  // namespace
+
+KinematicsMetrics::JointLimitsData KinematicsMetrics::getJointLimitsData(
+    const robot_model::JointModelGroup* joint_model_group) const
+{
+  JointLimitsData data;
   if (fabs(penalty_multiplier_) <= boost::math::tools::epsilon<double>())
-    return 1.0;
-  double joint_limits_multiplier(1.0);
+    return data;
   const std::vector<const robot_model::JointModel*>& joint_model_vector = joint_model_group->getJointModels();
   for (const robot_model::JointModel* joint_model : joint_model_vector)
   {
@@ -73,16 +143,30 @@ double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& s
       // Joint limits are not well-defined for floating joints
       continue;
     }
-    const double* joint_values = state.getJointPositions(joint_model);
-    const robot_model::JointModel::Bounds& bounds = joint_model->getVariableBounds();
-    std::vector<double> lower_bounds, upper_bounds;
-    for (const moveit::core::VariableBounds& bound : bounds)
+    data.joint_models_.push_back(joint_model);
+    data.lower_bounds_.emplace_back();
+    data.upper_bounds_.emplace_back();
+    for (const moveit::core::VariableBounds& bound : joint_model->getVariableBounds())
     {
-      lower_bounds.push_back(bound.min_position_);
-      upper_bounds.push_back(bound.max_position_);
+      data.lower_bounds_.back().push_back(bound.min_position_);
+      data.upper_bounds_.back().push_back(bound.max_position_);
     }
-    double lower_bound_distance = joint_model->distance(joint_values, &lower_bounds[0]);
-    double upper_bound_distance = joint_model->distance(joint_values, &upper_bounds[0]);
+  }
+  return data;
+}
+
+double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& state,
+                                                const JointLimitsData& data) const
+{
+  if (fabs(penalty_multiplier_) <= boost::math::tools::epsilon<double>())
+    return 1.0;
+  double joint_limits_multiplier(1.0);
+  for (std::size_t i = 0; i < data.joint_models_.size(); ++i)
+  {
+    const robot_model::JointModel* joint_model = data.joint_models_[i];
+    const double* joint_values = state.getJointPositions(joint_model);
+    double lower_bound_distance = joint_model->distance(joint_values, &data.lower_bounds_[i][0]);
+    double upper_bound_distance = joint_model->distance(joint_values, &data.upper_bounds_[i][0]);
     double range = lower_bound_distance + upper_bound_distance;
     if (range <= boost::math::tools::epsilon<double>())
       continue;
@@ -91,6 +175,12 @@ double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& s
   return (1.0 - exp(-penalty_multiplier_ * joint_limits_multiplier));
 }
 
+double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& state,
+                                                const robot_model::JointModelGroup* joint_model_group) const
+{
+  return getJointLimitsPenalty(state, getJointLimitsData(joint_model_group));
+}
+
 bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& state, const std::string& group_name,
                                                double& manipulability_index, bool translation) const
 {
@@ -114,51 +204,45 @@ bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& st
   Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
   // Get joint limits penalty
   double penalty = getJointLimitsPenalty(state, joint_model_group);
-  if (translation)
+  // Get manipulability index
+  manipulability_index = penalty * manipulabilityIndex(jacobian, translation);
+  return true;
+}
+
+bool KinematicsMetrics::getManipulabilityIndices(const robot_state::RobotState& state,
+                                                 const robot_model::JointModelGroup* joint_model_group,
+                                                 const std::vector<std::vector<double> >& joint_values,
+                                                 std::vector<double>& manipulability_indices, bool translation,
+                                                 unsigned int num_threads) const
+{
+  // state.getJacobian() only works for chain groups.
+  if (!joint_model_group->isChain())
   {
-    if (jacobian.cols() < 6)
-    {
-      Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian.topLeftCorner(3, jacobian.cols()));
-      Eigen::MatrixXd singular_values = svdsolver.singularValues();
-      manipulability_index = 1.0;
-      for (unsigned int i = 0; i < singular_values.rows(); ++i)
-      {
-        ROS_DEBUG_NAMED("kinematics_metrics", "Singular value: %d %f", i, singular_values(i, 0));
-        manipulability_index *= singular_values(i, 0);
-      }
-      // Get manipulability index
-      manipulability_index = penalty * manipulability_index;
-    }
-    else
-    {
-      Eigen::MatrixXd jacobian_2 = jacobian.topLeftCorner(3, jacobian.cols());
-      Eigen::MatrixXd matrix = jacobian_2 * jacobian_2.transpose();
-      // Get manipulability index
-      manipulability_index = penalty * sqrt(matrix.determinant());
-    }
+    return false;
   }
-  else
-  {
-    if (jacobian.cols() < 6)
+  for (const std::vector<double>& values : joint_values)
+    if (values.size() != joint_model_group->getVariableCount())
     {
-      Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian);
-      Eigen::MatrixXd singular_values = svdsolver.singularValues();
-      manipulability_index = 1.0;
-      for (unsigned int i = 0; i < singular_values.rows(); ++i)
-      {
-        ROS_DEBUG_NAMED("kinematics_metrics", "Singular value: %d %f", i, singular_values(i, 0));
-        manipulability_index *= singular_values(i, 0);
-      }
-      // Get manipulability index
-      manipulability_index = penalty * manipulability_index;
+      ROS_ERROR_NAMED("kinematics_metrics", "Joint values vector should be size %u",
+                      joint_model_group->getVariableCount());
+      return false;
     }
-    else
+
+  const JointLimitsData limits = getJointLimitsData(joint_model_group);
+  const robot_model::LinkModel* tip = joint_model_group->getLinkModels().back();
+  manipulability_indices.resize(joint_values.size());
+  moveit::core::runChunked(joint_values.size(), num_threads, [&](std::size_t begin, std::size_t end) {
+    robot_state::RobotState thread_state(state);
+    Eigen::MatrixXd jacobian;
+    for (std::size_t i = begin; i < end; ++i)
     {
-      Eigen::MatrixXd matrix = jacobian * jacobian.transpose();
-      // Get manipulability index
-      manipulability_index = penalty * sqrt(matrix.determinant());
+      thread_state.setJointGroupPositions(joint_model_group, joint_values[i]);
+      thread_state.getJacobian(joint_model_group, tip, Eigen::Vector3d::Zero(), jacobian);
+      manipulability_indices[i] =
+          getJointLimitsPenalty(thread_state, limits) * manipulabilityIndex(jacobian, translation);
     }
-  }
+    return true;
+  });
   return true;
 }
 
@@ -185,10 +269,44 @@ bool KinematicsMetrics::getManipulabilityEllipsoid(const robot_state::RobotState
   }
 
   Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
-  Eigen::MatrixXd matrix = jacobian * jacobian.transpose();
-  Eigen::EigenSolver<Eigen::MatrixXd> eigensolver(matrix.block(0, 0, 3, 3));
-  eigen_values = eigensolver.eigenvalues();
-  eigen_vectors = eigensolver.eigenvectors();
+  manipulabilityEllipsoid(jacobian, eigen_values, eigen_vectors);
+  return true;
+}
+
+bool KinematicsMetrics::getManipulabilityEllipsoids(const robot_state::RobotState& state,
+                                                    const robot_model::JointModelGroup* joint_model_group,
+                                                    const std::vector<std::vector<double> >& joint_values,
+                                                    std::vector<Eigen::MatrixXcd>& eigen_values,
+                                                    std::vector<Eigen::MatrixXcd>& eigen_vectors,
+                                                    unsigned int num_threads) const
+{
+  // state.getJacobian() only works for chain groups.
+  if (!joint_model_group->isChain())
+  {
+    return false;
+  }
+  for (const std::vector<double>& values : joint_values)
+    if (values.size() != joint_model_group->getVariableCount())
+    {
+      ROS_ERROR_NAMED("kinematics_metrics", "Joint values vector should be size %u",
+                      joint_model_group->getVariableCount());
+      return false;
+    }
+
+  const robot_model::LinkModel* tip = joint_model_group->getLinkModels().back();
+  eigen_values.resize(joint_values.size());
+  eigen_vectors.resize(joint_values.size());
+  moveit::core::runChunked(joint_values.size(), num_threads, [&](std::size_t begin, std::size_t end) {
+    robot_state::RobotState thread_state(state);
+    Eigen::MatrixXd jacobian;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      thread_state.setJointGroupPositions(joint_model_group, joint_values[i]);
+      thread_state.getJacobian(joint_model_group, tip, Eigen::Vector3d::Zero(), jacobian);
+      manipulabilityEllipsoid(jacobian, eigen_values[i], eigen_vectors[i]);
+    }
+    return true;
+  });
   return true;
 }
 
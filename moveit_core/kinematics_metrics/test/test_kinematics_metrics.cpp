@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <Eigen/Eigenvalues>
+#include <gtest/gtest.h>
+#include <algorithm>
+
+class KinematicsMetricsTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("pr2");
+    group_ = robot_model_->getJointModelGroup("right_arm");
+    ASSERT_TRUE(group_);
+    metrics_.reset(new kinematics_metrics::KinematicsMetrics(robot_model_));
+    metrics_->setPenaltyMultiplier(1.0);
+
+    state_.reset(new robot_state::RobotState(robot_model_));
+    state_->setToDefaultValues();
+    state_->update();
+    robot_state::RobotState random_state(*state_);
+    for (int i = 0; i < 20; ++i)
+    {
+      random_state.setToRandomPositions(group_);
+      joint_values_.emplace_back();
+      random_state.copyJointGroupPositions(group_, joint_values_.back());
+    }
+  }
+
+  /** \brief A copy of the default state with the group set to configuration \e i */
+  robot_state::RobotState stateAt(std::size_t i) const
+  {
+    robot_state::RobotState state(*state_);
+    state.setJointGroupPositions(group_, joint_values_[i]);
+    state.update();
+    return state;
+  }
+
+  /** \brief The real parts of the eigen values, sorted, so solvers are free to order them differently */
+  static std::vector<double> sortedRealParts(const Eigen::MatrixXcd& eigen_values)
+  {
+    std::vector<double> values;
+    for (Eigen::Index i = 0; i < eigen_values.size(); ++i)
+      values.push_back(eigen_values(i).real());
+    std::sort(values.begin(), values.end());
+    return values;
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+  const robot_model::JointModelGroup* group_;
+  kinematics_metrics::KinematicsMetricsPtr metrics_;
+  robot_state::RobotStatePtr state_;
+  std::vector<std::vector<double> > joint_values_;
+};
+
+TEST_F(KinematicsMetricsTest, BatchedIndicesMatchSingleState)
+{
+  for (bool translation : { false, true })
+    for (unsigned int num_threads : { 1, 3 })
+    {
+      std::vector<double> indices;
+      ASSERT_TRUE(metrics_->getManipulabilityIndices(*state_, group_, joint_values_, indices, translation, num_threads));
+      ASSERT_EQ(indices.size(), joint_values_.size());
+      for (std::size_t i = 0; i < joint_values_.size(); ++i)
+      {
+        double index;
+        ASSERT_TRUE(metrics_->getManipulabilityIndex(stateAt(i), group_, index, translation));
+        EXPECT_NEAR(indices[i], index, 1e-12) << "configuration " << i << ", translation " << translation;
+      }
+    }
+}
+
+TEST_F(KinematicsMetricsTest, BatchedEllipsoidsMatchSingleState)
+{
+  for (unsigned int num_threads : { 1, 3 })
+  {
+    std::vector<Eigen::MatrixXcd> eigen_values, eigen_vectors;
+    ASSERT_TRUE(
+        metrics_->getManipulabilityEllipsoids(*state_, group_, joint_values_, eigen_values, eigen_vectors, num_threads));
+    ASSERT_EQ(eigen_values.size(), joint_values_.size());
+    ASSERT_EQ(eigen_vectors.size(), joint_values_.size());
+    for (std::size_t i = 0; i < joint_values_.size(); ++i)
+    {
+      const robot_state::RobotState state = stateAt(i);
+      Eigen::MatrixXcd single_values, single_vectors;
+      ASSERT_TRUE(metrics_->getManipulabilityEllipsoid(state, group_, single_values, single_vectors));
+      EXPECT_TRUE(eigen_values[i].isApprox(single_values, 1e-12)) << "configuration " << i;
+      EXPECT_TRUE(eigen_vectors[i].isApprox(single_vectors, 1e-12)) << "configuration " << i;
+
+      // the translation block of J * J^T, as the ellipsoid used to be computed
+      const Eigen::MatrixXd jacobian = state.getJacobian(group_);
+      const Eigen::MatrixXd matrix = jacobian * jacobian.transpose();
+      Eigen::EigenSolver<Eigen::MatrixXd> eigensolver(matrix.block(0, 0, 3, 3));
+      const std::vector<double> expected = sortedRealParts(eigensolver.eigenvalues());
+      const std::vector<double> actual = sortedRealParts(eigen_values[i]);
+      ASSERT_EQ(actual.size(), expected.size());
+      for (std::size_t j = 0; j < expected.size(); ++j)
+        EXPECT_NEAR(actual[j], expected[j], 1e-9) << "configuration " << i;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -488,6 +488,7 @@ void PlanningScene::pushDiffs(const PlanningScenePtr& scene)
 
   if (world_diff_)
   {
+    collision_detection::World::Batch batch(*scene->world_);
     for (const std::pair<const std::string, collision_detection::World::Action>& it : *world_diff_)
     {
       if (it.second == collision_detection::World::DESTROY)
@@ -1286,7 +1287,8 @@ bool PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::PlanningScene& sc
   for (const moveit_msgs::ObjectColor& object_color : scene_msg.object_colors)
     setObjectColor(object_color.id, object_color.color);
 
-  // process collision object updates
+  // process collision object updates; observers of the world are notified once all of them are applied
+  collision_detection::World::Batch batch(*world_);
   for (const moveit_msgs::CollisionObject& collision_object : scene_msg.world.collision_objects)
     result &= processCollisionObjectMsg(collision_object);
 
@@ -1326,12 +1328,14 @@ bool PlanningScene::setPlanningSceneMsg(const moveit_msgs::PlanningScene& scene_
   object_colors_.reset(new ObjectColorMap());
   for (const moveit_msgs::ObjectColor& object_color : scene_msg.object_colors)
     setObjectColor(object_color.id, object_color.color);
+  collision_detection::World::Batch batch(*world_);
   world_->clearObjects();
   return processPlanningSceneWorldMsg(scene_msg.world);
 }
 
 bool PlanningScene::processPlanningSceneWorldMsg(const moveit_msgs::PlanningSceneWorld& world)
 {
+  collision_detection::World::Batch batch(*world_);
   bool result = true;
   for (const moveit_msgs::CollisionObject& collision_object : world.collision_objects)
     result &= processCollisionObjectMsg(collision_object);
@@ -2145,7 +2149,7 @@ bool PlanningScene::isStateConstrained(const moveit_msgs::RobotState& state,
 bool PlanningScene::isStateConstrained(const robot_state::RobotState& state,
                                        const kinematic_constraints::KinematicConstraintSet& constr, bool verbose) const
 {
-  return constr.decide(state, verbose).satisfied;
+  return constr.satisfies(state, verbose);
 }
 
 bool PlanningScene::isStateValid(const robot_state::RobotState& state, const std::string& group, bool verbose) const
@@ -2241,6 +2245,19 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
   kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
   ks_p.add(path_constraints, getTransforms());
   std::size_t n_wp = trajectory.getWayPointCount();
+
+  // when all invalid waypoints are requested, evaluate the path constraints for all of them at once;
+  // otherwise check them per waypoint, so we can stop at the first invalid one
+  const bool batch_constraints = invalid_index && !ks_p.empty();
+  std::vector<bool> constraints_satisfied;
+  if (batch_constraints)
+  {
+    std::vector<const robot_state::RobotState*> waypoints(n_wp);
+    for (std::size_t i = 0; i < n_wp; ++i)
+      waypoints[i] = &trajectory.getWayPoint(i);
+    ks_p.satisfies(waypoints, constraints_satisfied);
+  }
+
   for (std::size_t i = 0; i < n_wp; ++i)
   {
     const robot_state::RobotState& st = trajectory.getWayPoint(i);
@@ -2250,7 +2267,16 @@ bool PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& traject
       this_state_valid = false;
     if (!isStateFeasible(st, verbose))
       this_state_valid = false;
-    if (!ks_p.empty() && !ks_p.decide(st, verbose).satisfied)
+    if (batch_constraints)
+    {
+      if (!constraints_satisfied[i])
+      {
+        if (verbose)
+          ks_p.satisfies(st, verbose);  // report the violated constraints
+        this_state_valid = false;
+      }
+    }
+    else if (!ks_p.empty() && !ks_p.satisfies(st, verbose))
       this_state_valid = false;
 
     if (!this_state_valid)
@@ -0,0 +1,78 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_ROBOT_MODEL_MESH_CACHE_
+#define MOVEIT_ROBOT_MODEL_MESH_CACHE_
+
+#include <moveit/macros/class_forward.h>
+#include <geometric_shapes/shapes.h>
+#include <Eigen/Core>
+#include <string>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(MeshCache);
+
+/** \brief An on-disk cache of decoded meshes, shared between processes that load the same robot.
+
+    Importing meshes (with assimp) dominates the construction time of a RobotModel. The cache stores every decoded
+    mesh in a binary file named after a hash of the mesh file contents and the scale, so later loads read the
+    vertices and triangles directly. Changed mesh files hash differently and are imported again. */
+class MeshCache
+{
+public:
+  /** \brief Use (and create if needed) \e directory to store the cached meshes */
+  MeshCache(const std::string& directory);
+
+  const std::string& getDirectory() const
+  {
+    return directory_;
+  }
+
+  /** \brief Load the mesh at \e resource (a URL understood by resource_retriever), scaled by \e scale.
+      Returns nullptr if the resource cannot be loaded. Safe to call from multiple threads and processes. */
+  shapes::Mesh* loadMesh(const std::string& resource, const Eigen::Vector3d& scale) const;
+
+private:
+  shapes::Mesh* readCacheFile(const std::string& path) const;
+  void writeCacheFile(const std::string& path, const shapes::Mesh& mesh) const;
+
+  std::string directory_;
+};
+}
+}
+
+#endif
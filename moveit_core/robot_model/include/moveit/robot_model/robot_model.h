@@ -50,8 +50,10 @@
 #include <moveit/robot_model/planar_joint_model.h>
 #include <moveit/robot_model/revolute_joint_model.h>
 #include <moveit/robot_model/prismatic_joint_model.h>
+#include <moveit/robot_model/mesh_cache.h>
 
 #include <Eigen/Geometry>
+#include <array>
 #include <iostream>
 
 /** \brief Main namespace for MoveIt! */
@@ -67,8 +69,12 @@ MOVEIT_CLASS_FORWARD(RobotModel);
 class RobotModel
 {
 public:
-  /** \brief Construct a kinematic model from a parsed description and a list of planning groups */
-  RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model);
+  /** \brief Construct a kinematic model from a parsed description and a list of planning groups.
+      If \e mesh_cache is specified, meshes are loaded through it instead of being imported every time.
+      Meshes are decoded on up to \e mesh_loading_threads threads (0 uses the number of CPU cores); the resulting
+      model does not depend on the number of threads */
+  RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model,
+             const MeshCacheConstPtr& mesh_cache = MeshCacheConstPtr(), unsigned int mesh_loading_threads = 0);
 
   /** \brief Destructor. Clear all memory. */
   ~RobotModel();
@@ -461,6 +467,18 @@ protected:
 
   urdf::ModelInterfaceSharedPtr urdf_;
 
+  /** \brief The cache meshes are loaded from while building the model (if any) */
+  MeshCacheConstPtr mesh_cache_;
+
+  /** \brief The number of threads meshes are decoded on while building the model (0 for the number of CPU cores) */
+  unsigned int mesh_loading_threads_;
+
+  /** \brief A mesh file name and the scale it is loaded with */
+  typedef std::pair<std::string, std::array<double, 3> > MeshKey;
+
+  /** \brief Meshes decoded by preloadMeshes(), only used while the model is being built */
+  std::map<MeshKey, shapes::ShapePtr> preloaded_meshes_;
+
   // LINKS
 
   /** \brief The first physical link for the robot */
@@ -615,6 +633,13 @@ protected:
 
   /** \brief Given a geometry spec from the URDF and a filename (for a mesh), construct the corresponding shape object*/
   shapes::ShapePtr constructShape(const urdf::Geometry* geom);
+
+  /** \brief Decode all meshes constructLinkModel() is going to need in parallel and store them in
+      preloaded_meshes_. The results do not depend on the number of threads */
+  void preloadMeshes(const urdf::ModelInterface& urdf_model);
+
+  /** \brief Decode a single mesh, through the mesh cache if there is one */
+  shapes::Mesh* loadMesh(const MeshKey& key) const;
 };
 }
 }
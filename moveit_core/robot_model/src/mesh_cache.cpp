@@ -0,0 +1,208 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model/mesh_cache.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <resource_retriever/retriever.h>
+#include <boost/filesystem.hpp>
+#include <ros/console.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+const std::string LOGNAME = "mesh_cache";
+
+// bump the version when the file layout changes, so stale files are not read
+const char CACHE_FILE_MAGIC[4] = { 'M', 'M', 'S', 'H' };
+const std::uint32_t CACHE_FILE_VERSION = 1;
+
+struct CacheFileHeader
+{
+  char magic_[4];
+  std::uint32_t version_;
+  std::uint32_t vertex_count_;
+  std::uint32_t triangle_count_;
+};
+
+// 64-bit FNV-1a; unlike std::hash the value is stable across builds, which matters for files other processes read
+std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t hash = 14695981039346656037ULL)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+}  // namespace
+
+MeshCache::MeshCache(const std::string& directory) : directory_(directory)
+{
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(directory_, ec);
+  if (ec)
+    ROS_WARN_NAMED(LOGNAME, "Unable to create mesh cache directory '%s': %s", directory_.c_str(),
+                   ec.message().c_str());
+}
+
+shapes::Mesh* MeshCache::loadMesh(const std::string& resource, const Eigen::Vector3d& scale) const
+{
+  resource_retriever::Retriever retriever;
+  resource_retriever::MemoryResource res;
+  try
+  {
+    res = retriever.get(resource);
+  }
+  catch (resource_retriever::Exception& e)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "%s", e.what());
+    return nullptr;
+  }
+  if (res.size == 0)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Retrieved empty mesh for resource '%s'", resource.c_str());
+    return nullptr;
+  }
+
+  // the key covers everything the decoded mesh depends on: the file contents and the scale
+  std::uint64_t hash = hashBytes(res.data.get(), res.size);
+  hash = hashBytes(scale.data(), 3 * sizeof(double), hash);
+  std::stringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << hash << ".mesh";
+  const std::string path = (boost::filesystem::path(directory_) / name.str()).string();
+
+  shapes::Mesh* mesh = readCacheFile(path);
+  if (mesh)
+    return mesh;
+
+  mesh = shapes::createMeshFromBinary(reinterpret_cast<const char*>(res.data.get()), res.size, scale, resource);
+  if (mesh)
+    writeCacheFile(path, *mesh);
+  return mesh;
+}
+
+shapes::Mesh* MeshCache::readCacheFile(const std::string& path) const
+{
+  std::ifstream in(path.c_str(), std::ios::in | std::ios::binary);
+  if (!in.good())
+    return nullptr;
+
+  CacheFileHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic_, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0 ||
+      header.version_ != CACHE_FILE_VERSION)
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "Ignoring invalid mesh cache file '%s'", path.c_str());
+    return nullptr;
+  }
+
+  // the counts are checked against the file size before anything is allocated for them
+  in.seekg(0, std::ios::end);
+  const std::uint64_t file_size = static_cast<std::uint64_t>(in.tellg());
+  const std::uint64_t expected_size = sizeof(header) + 3 * sizeof(double) * std::uint64_t(header.vertex_count_) +
+                                      3 * sizeof(unsigned int) * std::uint64_t(header.triangle_count_);
+  if (!in.seekg(sizeof(header), std::ios::beg) || file_size != expected_size)
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "Ignoring mesh cache file '%s' of unexpected size", path.c_str());
+    return nullptr;
+  }
+
+  shapes::Mesh* mesh = new shapes::Mesh(header.vertex_count_, header.triangle_count_);
+  if (!in.read(reinterpret_cast<char*>(mesh->vertices), 3 * sizeof(double) * header.vertex_count_) ||
+      !in.read(reinterpret_cast<char*>(mesh->triangles), 3 * sizeof(unsigned int) * header.triangle_count_))
+  {
+    ROS_DEBUG_NAMED(LOGNAME, "Ignoring truncated mesh cache file '%s'", path.c_str());
+    delete mesh;
+    return nullptr;
+  }
+
+  for (unsigned int i = 0; i < 3 * mesh->triangle_count; ++i)
+    if (mesh->triangles[i] >= mesh->vertex_count)
+    {
+      ROS_DEBUG_NAMED(LOGNAME, "Ignoring mesh cache file '%s' with invalid vertex indices", path.c_str());
+      delete mesh;
+      return nullptr;
+    }
+
+  // normals are cheap to compute compared to reading them, and this is what the mesh import does as well
+  mesh->computeTriangleNormals();
+  mesh->computeVertexNormals();
+  return mesh;
+}
+
+void MeshCache::writeCacheFile(const std::string& path, const shapes::Mesh& mesh) const
+{
+  // write to a unique temporary file and rename it, so concurrent readers never see a partially written file
+  boost::system::error_code ec;
+  const boost::filesystem::path tmp_path = boost::filesystem::unique_path(path + ".%%%%-%%%%-%%%%", ec);
+  if (ec)
+    return;
+
+  {
+    std::ofstream out(tmp_path.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    CacheFileHeader header;
+    std::memcpy(header.magic_, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+    header.version_ = CACHE_FILE_VERSION;
+    header.vertex_count_ = mesh.vertex_count;
+    header.triangle_count_ = mesh.triangle_count;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(mesh.vertices), 3 * sizeof(double) * mesh.vertex_count);
+    out.write(reinterpret_cast<const char*>(mesh.triangles), 3 * sizeof(unsigned int) * mesh.triangle_count);
+    if (!out.good())
+    {
+      ROS_WARN_NAMED(LOGNAME, "Unable to write mesh cache file '%s'", tmp_path.string().c_str());
+      out.close();
+      boost::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+
+  boost::filesystem::rename(tmp_path, path, ec);
+  if (ec)
+  {
+    ROS_WARN_NAMED(LOGNAME, "Unable to store mesh cache file '%s': %s", path.c_str(), ec.message().c_str());
+    boost::filesystem::remove(tmp_path, ec);
+  }
+}
+}  // end of namespace core
+}  // end of namespace moveit
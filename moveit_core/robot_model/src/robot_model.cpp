@@ -39,7 +39,9 @@
 #include <geometric_shapes/shape_operations.h>
 #include <boost/math/constants/constants.hpp>
 #include <moveit/profiler/profiler.h>
+#include <boost/thread/thread.hpp>
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <queue>
 #include <cmath>
@@ -52,11 +54,14 @@ namespace core
 {
 const std::string LOGNAME = "robot_model";
 
-RobotModel::RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model)
+RobotModel::RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model,
+                       const MeshCacheConstPtr& mesh_cache, unsigned int mesh_loading_threads)
 {
   root_joint_ = nullptr;
   urdf_ = urdf_model;
   srdf_ = srdf_model;
+  mesh_cache_ = mesh_cache;
+  mesh_loading_threads_ = mesh_loading_threads;
   buildModel(*urdf_model, *srdf_model);
 }
 
@@ -97,8 +102,12 @@ void RobotModel::buildModel(const urdf::ModelInterface& urdf_model, const srdf::
     const urdf::Link* root_link_ptr = urdf_model.getRoot().get();
     model_frame_ = root_link_ptr->name;
 
+    ROS_DEBUG_NAMED(LOGNAME, "... loading meshes");
+    preloadMeshes(urdf_model);
+
     ROS_DEBUG_NAMED(LOGNAME, "... building kinematic chain");
     root_joint_ = buildRecursive(nullptr, root_link_ptr, srdf_model);
+    preloaded_meshes_.clear();
     if (root_joint_)
       root_link_ = root_joint_->getChildLinkModel();
     ROS_DEBUG_NAMED(LOGNAME, "... building mimic joints");
@@ -1053,9 +1062,14 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
       const urdf::Mesh* mesh = static_cast<const urdf::Mesh*>(geom);
       if (!mesh->filename.empty())
       {
-        Eigen::Vector3d scale(mesh->scale.x, mesh->scale.y, mesh->scale.z);
-        shapes::Mesh* m = shapes::createMeshFromResource(mesh->filename, scale);
-        result = m;
+        const MeshKey key(mesh->filename, { { mesh->scale.x, mesh->scale.y, mesh->scale.z } });
+        std::map<MeshKey, shapes::ShapePtr>::iterator it = preloaded_meshes_.find(key);
+        if (it == preloaded_meshes_.end())
+          result = loadMesh(key);
+        else if (it->second.unique())
+          return it->second;  // first use: hand out the preloaded instance, the map keeps a reference for reuse
+        else if (it->second)
+          result = it->second->clone();  // the same mesh is used by more links; each gets its own instance
       }
     }
     break;
@@ -1067,6 +1081,74 @@ shapes::ShapePtr RobotModel::constructShape(const urdf::Geometry* geom)
   return shapes::ShapePtr(result);
 }
 
+shapes::Mesh* RobotModel::loadMesh(const MeshKey& key) const
+{
+  Eigen::Vector3d scale(key.second[0], key.second[1], key.second[2]);
+  return mesh_cache_ ? mesh_cache_->loadMesh(key.first, scale) : shapes::createMeshFromResource(key.first, scale);
+}
+
+void RobotModel::preloadMeshes(const urdf::ModelInterface& urdf_model)
+{
+  moveit::tools::Profiler::ScopedBlock prof_block("RobotModel::preloadMeshes");
+
+  // collect the meshes the same way constructLinkModel() uses them: collision geometry if there is any,
+  // visual geometry otherwise
+  preloaded_meshes_.clear();
+  for (const std::pair<const std::string, urdf::LinkSharedPtr>& link : urdf_model.links_)
+  {
+    std::vector<const urdf::Geometry*> geometries;
+    const std::vector<urdf::CollisionSharedPtr>& col_array =
+        link.second->collision_array.empty() ? std::vector<urdf::CollisionSharedPtr>(1, link.second->collision) :
+                                               link.second->collision_array;
+    for (const urdf::CollisionSharedPtr& col : col_array)
+      if (col && col->geometry)
+        geometries.push_back(col->geometry.get());
+    if (geometries.empty())
+    {
+      const std::vector<urdf::VisualSharedPtr>& vis_array =
+          link.second->visual_array.empty() ? std::vector<urdf::VisualSharedPtr>(1, link.second->visual) :
+                                              link.second->visual_array;
+      for (const urdf::VisualSharedPtr& vis : vis_array)
+        if (vis && vis->geometry)
+          geometries.push_back(vis->geometry.get());
+    }
+
+    for (const urdf::Geometry* geom : geometries)
+      if (geom->type == urdf::Geometry::MESH)
+      {
+        const urdf::Mesh* mesh = static_cast<const urdf::Mesh*>(geom);
+        if (!mesh->filename.empty())
+          preloaded_meshes_[MeshKey(mesh->filename, { { mesh->scale.x, mesh->scale.y, mesh->scale.z } })];
+      }
+  }
+  if (preloaded_meshes_.empty())
+    return;
+
+  // every mesh is decoded by exactly one thread into its own slot, so the result is independent of the scheduling
+  std::vector<std::map<MeshKey, shapes::ShapePtr>::iterator> slots;
+  for (std::map<MeshKey, shapes::ShapePtr>::iterator it = preloaded_meshes_.begin(); it != preloaded_meshes_.end();
+       ++it)
+    slots.push_back(it);
+
+  const unsigned int max_threads =
+      mesh_loading_threads_ > 0 ? mesh_loading_threads_ : std::max(1u, boost::thread::hardware_concurrency());
+  const std::size_t num_threads = std::min<std::size_t>(slots.size(), max_threads);
+  std::atomic<std::size_t> next(0);
+  auto work = [this, &slots, &next] {
+    for (std::size_t i = next++; i < slots.size(); i = next++)
+      slots[i]->second.reset(loadMesh(slots[i]->first));
+  };
+  if (num_threads == 1)
+    work();
+  else
+  {
+    boost::thread_group threads;
+    for (std::size_t t = 0; t < num_threads; ++t)
+      threads.create_thread(work);
+    threads.join_all();
+  }
+}
+
 bool RobotModel::hasJointModel(const std::string& name) const
 {
   return joint_model_map_.find(name) != joint_model_map_.end();
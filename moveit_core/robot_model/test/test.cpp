@@ -36,9 +36,10 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <urdf_parser/urdf_parser.h>
+#include <cstdint>
 #include <fstream>
 #include <gtest/gtest.h>
-#include <boost/filesystem/path.hpp>
+#include <boost/filesystem.hpp>
 #include <moveit/profiler/profiler.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
@@ -82,6 +83,129 @@ TEST_F(LoadPlanningModelsPr2, Model)
   moveit::tools::Profiler::Status();
 }
 
+TEST_F(LoadPlanningModelsPr2, MeshLoadingThreads)
+{
+  // the meshes do not depend on the number of threads decoding them
+  moveit::core::RobotModel serial_model(robot_model_->getURDF(), robot_model_->getSRDF(),
+                                        moveit::core::MeshCacheConstPtr(), 1);
+  moveit::core::RobotModel parallel_model(robot_model_->getURDF(), robot_model_->getSRDF(),
+                                          moveit::core::MeshCacheConstPtr(), 4);
+  std::size_t mesh_count = 0;
+  for (const moveit::core::LinkModel* link : serial_model.getLinkModels())
+  {
+    const std::vector<shapes::ShapeConstPtr>& expected = link->getShapes();
+    const std::vector<shapes::ShapeConstPtr>& actual = parallel_model.getLinkModel(link->getName())->getShapes();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+      ASSERT_EQ(expected[i]->type, actual[i]->type);
+      if (expected[i]->type != shapes::MESH)
+        continue;
+      ++mesh_count;
+      const shapes::Mesh* m1 = static_cast<const shapes::Mesh*>(expected[i].get());
+      const shapes::Mesh* m2 = static_cast<const shapes::Mesh*>(actual[i].get());
+      ASSERT_EQ(m1->vertex_count, m2->vertex_count);
+      ASSERT_EQ(m1->triangle_count, m2->triangle_count);
+      for (unsigned int j = 0; j < 3 * m1->vertex_count; ++j)
+        EXPECT_EQ(m1->vertices[j], m2->vertices[j]);
+      for (unsigned int j = 0; j < 3 * m1->triangle_count; ++j)
+        EXPECT_EQ(m1->triangles[j], m2->triangles[j]);
+    }
+  }
+  EXPECT_GT(mesh_count, 1u);
+}
+
+TEST_F(LoadPlanningModelsPr2, MeshCache)
+{
+  boost::filesystem::path cache_dir =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("moveit_mesh_cache_%%%%-%%%%");
+  moveit::core::MeshCacheConstPtr cache(new moveit::core::MeshCache(cache_dir.string()));
+
+  // the first model fills the cache, the second one reads from it
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    SCOPED_TRACE("pass: " + std::to_string(pass));
+    moveit::core::RobotModel cached_model(robot_model_->getURDF(), robot_model_->getSRDF(), cache);
+    EXPECT_FALSE(boost::filesystem::is_empty(cache_dir));
+    for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+    {
+      const std::vector<shapes::ShapeConstPtr>& expected = link->getShapes();
+      const std::vector<shapes::ShapeConstPtr>& actual = cached_model.getLinkModel(link->getName())->getShapes();
+      ASSERT_EQ(expected.size(), actual.size());
+      for (std::size_t i = 0; i < expected.size(); ++i)
+      {
+        ASSERT_EQ(expected[i]->type, actual[i]->type);
+        if (expected[i]->type != shapes::MESH)
+          continue;
+        const shapes::Mesh* m1 = static_cast<const shapes::Mesh*>(expected[i].get());
+        const shapes::Mesh* m2 = static_cast<const shapes::Mesh*>(actual[i].get());
+        ASSERT_EQ(m1->vertex_count, m2->vertex_count);
+        ASSERT_EQ(m1->triangle_count, m2->triangle_count);
+        for (unsigned int j = 0; j < 3 * m1->vertex_count; ++j)
+          EXPECT_EQ(m1->vertices[j], m2->vertices[j]);
+        for (unsigned int j = 0; j < 3 * m1->triangle_count; ++j)
+          EXPECT_EQ(m1->triangles[j], m2->triangles[j]);
+      }
+    }
+  }
+
+  boost::filesystem::remove_all(cache_dir);
+}
+
+TEST_F(LoadPlanningModelsPr2, MeshCacheRejectsCorruptFiles)
+{
+  boost::filesystem::path cache_dir =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("moveit_mesh_cache_%%%%-%%%%");
+  moveit::core::MeshCacheConstPtr cache(new moveit::core::MeshCache(cache_dir.string()));
+  moveit::core::RobotModel filling_model(robot_model_->getURDF(), robot_model_->getSRDF(), cache);
+
+  // alternately claim an impossible vertex count and make the first triangle refer to a vertex that does not exist
+  std::size_t corrupted = 0;
+  for (boost::filesystem::directory_iterator it(cache_dir), end; it != end; ++it, ++corrupted)
+  {
+    std::fstream file(it->path().string().c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    std::uint32_t counts[2];
+    file.seekg(8);
+    ASSERT_TRUE(file.read(reinterpret_cast<char*>(counts), sizeof(counts)));
+    if (corrupted % 2 == 0 || counts[1] == 0)
+    {
+      const std::uint32_t vertex_count = 0x7fffffff;
+      file.seekp(8);
+      file.write(reinterpret_cast<const char*>(&vertex_count), sizeof(vertex_count));
+    }
+    else
+    {
+      const unsigned int index = counts[0];
+      file.seekp(16 + 3 * sizeof(double) * counts[0]);
+      file.write(reinterpret_cast<const char*>(&index), sizeof(index));
+    }
+    ASSERT_TRUE(file.good());
+  }
+  ASSERT_GT(corrupted, 1u);
+
+  // the corrupt files are ignored and the meshes decoded again
+  moveit::core::RobotModel cached_model(robot_model_->getURDF(), robot_model_->getSRDF(), cache);
+  for (const moveit::core::LinkModel* link : robot_model_->getLinkModels())
+  {
+    const std::vector<shapes::ShapeConstPtr>& expected = link->getShapes();
+    const std::vector<shapes::ShapeConstPtr>& actual = cached_model.getLinkModel(link->getName())->getShapes();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+      if (expected[i]->type != shapes::MESH)
+        continue;
+      const shapes::Mesh* m1 = static_cast<const shapes::Mesh*>(expected[i].get());
+      const shapes::Mesh* m2 = static_cast<const shapes::Mesh*>(actual[i].get());
+      ASSERT_EQ(m1->vertex_count, m2->vertex_count);
+      ASSERT_EQ(m1->triangle_count, m2->triangle_count);
+      for (unsigned int j = 0; j < 3 * m1->triangle_count; ++j)
+        EXPECT_EQ(m1->triangles[j], m2->triangles[j]);
+    }
+  }
+
+  boost::filesystem::remove_all(cache_dir);
+}
+
 TEST(SiblingAssociateLinks, SimpleYRobot)
 {
   /* base_link - a - b - c
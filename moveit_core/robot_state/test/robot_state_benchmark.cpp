@@ -36,38 +36,11 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/utils/robot_model_test_utils.h>
+#include <moveit/utils/benchmark_test_utils.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <gtest/gtest.h>
-#include <chrono>
 
-// Helper class to measure time within a scoped block and output the result
-class ScopedTimer
-{
-  const char* const msg_;
-  double* const gold_standard_;
-  const std::chrono::time_point<std::chrono::steady_clock> start_;
-
-public:
-  // if gold_standard is provided, a relative increase/decrease is shown too
-  ScopedTimer(const char* msg = "", double* gold_standard = nullptr)
-    : msg_(msg), gold_standard_(gold_standard), start_(std::chrono::steady_clock::now())
-  {
-  }
-
-  ~ScopedTimer()
-  {
-    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
-    std::cerr << msg_ << elapsed.count() * 1000. << "ms ";
-
-    if (gold_standard_)
-    {
-      if (*gold_standard_ == 0)
-        *gold_standard_ = elapsed.count();
-      std::cerr << 100 * elapsed.count() / *gold_standard_ << "%";
-    }
-    std::cerr << std::endl;
-  }
-};
+using moveit::core::ScopedTimer;
 
 class Timing : public testing::Test
 {
@@ -0,0 +1,78 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2018, CITEC Bielefeld
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the Willow Garage nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+/* Author: Robert Haschke */
+
+#ifndef MOVEIT_CORE_UTILS_BENCHMARK_TEST_UTILS_
+#define MOVEIT_CORE_UTILS_BENCHMARK_TEST_UTILS_
+
+#include <chrono>
+#include <iostream>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief Helper class to measure time within a scoped block and output the result */
+class ScopedTimer
+{
+  const char* const msg_;
+  double* const gold_standard_;
+  const std::chrono::time_point<std::chrono::steady_clock> start_;
+
+public:
+  // if gold_standard is provided, a relative increase/decrease is shown too
+  ScopedTimer(const char* msg = "", double* gold_standard = nullptr)
+    : msg_(msg), gold_standard_(gold_standard), start_(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+    std::cerr << msg_ << elapsed.count() * 1000. << "ms ";
+
+    if (gold_standard_)
+    {
+      if (*gold_standard_ == 0)
+        *gold_standard_ = elapsed.count();
+      std::cerr << 100 * elapsed.count() / *gold_standard_ << "%";
+    }
+    std::cerr << std::endl;
+  }
+};
+}
+}
+
+#endif
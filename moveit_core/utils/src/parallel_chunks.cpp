@@ -0,0 +1,70 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "moveit/utils/parallel_chunks.h"
+
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace moveit
+{
+namespace core
+{
+bool runChunked(std::size_t count, unsigned int num_threads,
+                const std::function<bool(std::size_t begin, std::size_t end)>& fn)
+{
+  if (count == 0)
+    return true;
+  if (num_threads == 0)
+    num_threads = std::max(1u, boost::thread::hardware_concurrency());
+  num_threads = std::min<std::size_t>(num_threads, count);
+  if (num_threads == 1)
+    return fn(0, count);
+
+  std::vector<char> results(num_threads, 0);
+  const std::size_t chunk = (count + num_threads - 1) / num_threads;
+  boost::thread_group threads;
+  for (unsigned int t = 0; t < num_threads; ++t)
+  {
+    const std::size_t begin = std::min(count, t * chunk);
+    const std::size_t end = std::min(count, begin + chunk);
+    threads.create_thread([&fn, &results, t, begin, end] { results[t] = fn(begin, end); });
+  }
+  threads.join_all();
+
+  return std::find(results.begin(), results.end(), 0) == results.end();
+}
+}
+}
@@ -45,12 +45,48 @@
 #include <kdl/frames_io.hpp>
 #include <kdl/kinfam_io.hpp>
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 // register KDLKinematics as a KinematicsBase implementation
 #include <class_loader/class_loader.hpp>
 CLASS_LOADER_REGISTER_CLASS(kdl_kinematics_plugin::KDLKinematicsPlugin, kinematics::KinematicsBase)
 
 namespace kdl_kinematics_plugin
 {
+namespace
+{
+/** \brief Parse the KDL tree of \e urdf only once for all solver instances.
+    Solvers for several groups of the same robot are typically initialized at the same time (in parallel even),
+    and each of them only needs to extract its chain from the tree. Returns nullptr if parsing fails. */
+std::shared_ptr<const KDL::Tree> getKDLTree(const urdf::ModelInterfaceSharedPtr& urdf)
+{
+  static std::mutex lock;
+  static std::map<const urdf::ModelInterface*,
+                  std::pair<std::weak_ptr<const urdf::ModelInterface>, std::shared_ptr<const KDL::Tree> > >
+      trees;
+
+  std::lock_guard<std::mutex> guard(lock);
+  // drop the trees of models that no longer exist, their addresses may get reused
+  for (auto it = trees.begin(); it != trees.end();)
+    if (it->second.first.expired())
+      it = trees.erase(it);
+    else
+      ++it;
+
+  auto it = trees.find(urdf.get());
+  if (it != trees.end())
+    return it->second.second;
+
+  auto tree = std::make_shared<KDL::Tree>();
+  if (!kdl_parser::treeFromUrdfModel(*urdf, *tree))
+    return nullptr;
+  trees[urdf.get()] = std::make_pair(std::weak_ptr<const urdf::ModelInterface>(urdf), tree);
+  return tree;
+}
+}  // namespace
+
 KDLKinematicsPlugin::KDLKinematicsPlugin() : initialized_(false)
 {
 }
@@ -154,14 +190,13 @@ bool KDLKinematicsPlugin::initialize(const moveit::core::RobotModel& robot_model
     return false;
   }
 
-  KDL::Tree kdl_tree;
-
-  if (!kdl_parser::treeFromUrdfModel(*robot_model.getURDF(), kdl_tree))
+  std::shared_ptr<const KDL::Tree> kdl_tree = getKDLTree(robot_model.getURDF());
+  if (!kdl_tree)
   {
     ROS_ERROR_NAMED("kdl", "Could not initialize tree object");
     return false;
   }
-  if (!kdl_tree.getChain(base_frame_, getTipFrame(), kdl_chain_))
+  if (!kdl_tree->getChain(base_frame_, getTipFrame(), kdl_chain_))
   {
     ROS_ERROR_NAMED("kdl", "Could not initialize chain object");
     return false;
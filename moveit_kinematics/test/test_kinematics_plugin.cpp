@@ -37,6 +37,8 @@
 
 #include <gtest/gtest.h>
 #include <memory>
+#include <thread>
+#include <typeinfo>
 #include <boost/bind.hpp>
 #include <pluginlib/class_loader.h>
 #include <ros/ros.h>
@@ -52,6 +54,7 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
 
 const std::string ROBOT_DESCRIPTION_PARAM = "robot_description";
 const double DEFAULT_SEARCH_DISCRETIZATION = 0.01f;
@@ -326,6 +329,108 @@ TEST_F(KinematicsTest, getFK)
   }
 }
 
+// solvers for the groups of a robot may be initialized in parallel, sharing the robot data they parse
+TEST_F(KinematicsTest, parallelInitialization)
+{
+  std::string plugin_name;
+  ASSERT_TRUE(getParam("ik_plugin_name", plugin_name));
+  std::vector<kinematics::KinematicsBasePtr> solvers(4);
+  for (kinematics::KinematicsBasePtr& solver : solvers)
+  {
+    solver = SharedData::instance().createUniqueInstance(plugin_name);
+    ASSERT_TRUE(bool(solver));
+  }
+
+  std::vector<char> initialized(solvers.size(), 0);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < solvers.size(); ++i)
+    threads.emplace_back([this, &solvers, &initialized, i] {
+      initialized[i] = solvers[i]->initialize(*robot_model_, group_name_, root_link_, { tip_link_ },
+                                              DEFAULT_SEARCH_DISCRETIZATION);
+    });
+  for (std::thread& thread : threads)
+    thread.join();
+
+  std::vector<double> joints(kinematics_solver_->getJointNames().size(), 0.0);
+  const std::vector<std::string>& tip_frames = kinematics_solver_->getTipFrames();
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  for (std::size_t i = 0; i < solvers.size(); ++i)
+  {
+    ASSERT_TRUE(initialized[i]) << "Solver " << i << " failed to initialize";
+    for (unsigned int j = 0; j < num_fk_tests_; ++j)
+    {
+      robot_state.setToRandomPositions(jmg_, this->rng_);
+      robot_state.copyJointGroupPositions(jmg_, joints);
+      std::vector<geometry_msgs::Pose> expected_poses, fk_poses;
+      EXPECT_TRUE(kinematics_solver_->getPositionFK(tip_frames, joints, expected_poses));
+      EXPECT_TRUE(solvers[i]->getPositionFK(tip_frames, joints, fk_poses));
+      EXPECT_NEAR_POSES(expected_poses, fk_poses, tolerance_);
+    }
+  }
+}
+
+// the RobotModelLoader allocates the same solvers serially and in parallel
+TEST_F(KinematicsTest, robotModelLoaderThreads)
+{
+  robot_model_loader::RobotModelLoader::Options serial_options(ROBOT_DESCRIPTION_PARAM);
+  serial_options.kinematics_solver_threads_ = 1;
+  robot_model_loader::RobotModelLoader serial_loader(serial_options);
+  robot_model_loader::RobotModelLoader::Options parallel_options(ROBOT_DESCRIPTION_PARAM);
+  parallel_options.kinematics_solver_threads_ = 4;
+  robot_model_loader::RobotModelLoader parallel_loader(parallel_options);
+
+  const std::vector<std::string>& groups = serial_loader.getKinematicsPluginLoader()->getKnownGroups();
+  ASSERT_FALSE(groups.empty());
+  EXPECT_EQ(groups, parallel_loader.getKinematicsPluginLoader()->getKnownGroups());
+  for (const std::string& group : groups)
+  {
+    const robot_model::JointModelGroup* serial_jmg = serial_loader.getModel()->getJointModelGroup(group);
+    const robot_model::JointModelGroup* parallel_jmg = parallel_loader.getModel()->getJointModelGroup(group);
+    ASSERT_TRUE(serial_jmg && parallel_jmg);
+    kinematics::KinematicsBaseConstPtr serial_solver = serial_jmg->getSolverInstance();
+    kinematics::KinematicsBaseConstPtr parallel_solver = parallel_jmg->getSolverInstance();
+    ASSERT_TRUE(serial_solver && parallel_solver) << group;
+    EXPECT_EQ(typeid(*serial_solver), typeid(*parallel_solver)) << group;
+    EXPECT_EQ(serial_solver->getTipFrames(), parallel_solver->getTipFrames()) << group;
+    EXPECT_EQ(serial_solver->getJointNames(), parallel_solver->getJointNames()) << group;
+  }
+
+  // the robot used here has a single group with a solver, so also allocate solvers for that group concurrently,
+  // as the loader does for several groups
+  robot_model::SolverAllocatorFn allocator = parallel_loader.getKinematicsPluginLoader()->getLoaderFunction();
+  const robot_model::JointModelGroup* jmg = parallel_loader.getModel()->getJointModelGroup(group_name_);
+  ASSERT_TRUE(allocator && jmg);
+  std::vector<kinematics::KinematicsBasePtr> solvers(4);
+  std::vector<std::thread> threads;
+  for (kinematics::KinematicsBasePtr& solver : solvers)
+    threads.emplace_back([&allocator, jmg, &solver] { solver = allocator(jmg); });
+  for (std::thread& thread : threads)
+    thread.join();
+
+  std::vector<double> joints(jmg->getVariableCount(), 0.0);
+  robot_state::RobotState robot_state(parallel_loader.getModel());
+  robot_state.setToDefaultValues();
+  for (const kinematics::KinematicsBasePtr& solver : solvers)
+  {
+    ASSERT_TRUE(bool(solver));
+    const std::vector<std::string>& tip_frames = solver->getTipFrames();
+    for (unsigned int i = 0; i < num_fk_tests_; ++i)
+    {
+      robot_state.setToRandomPositions(jmg, this->rng_);
+      robot_state.copyJointGroupPositions(jmg, joints);
+      std::vector<geometry_msgs::Pose> fk_poses;
+      EXPECT_TRUE(solver->getPositionFK(tip_frames, joints, fk_poses));
+
+      robot_state.updateLinkTransforms();
+      std::vector<geometry_msgs::Pose> model_poses;
+      for (const auto& tip : tip_frames)
+        model_poses.emplace_back(tf2::toMsg(robot_state.getGlobalLinkTransform(tip)));
+      EXPECT_NEAR_POSES(model_poses, fk_poses, tolerance_);
+    }
+  }
+}
+
 // perform random walk in joint-space, reaching poses via IK
 TEST_F(KinematicsTest, randomWalkIK)
 {
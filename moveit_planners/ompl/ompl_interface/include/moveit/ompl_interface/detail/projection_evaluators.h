@@ -40,6 +40,7 @@
 #include <ompl/config.h>
 #include <ompl/base/ProjectionEvaluator.h>
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <Eigen/StdVector>
 
 #if OMPL_VERSION_VALUE >= 1004000  // Version greater than 1.4.0
 typedef Eigen::Ref<Eigen::VectorXd> OMPLProjection;
@@ -56,6 +57,8 @@ class ModelBasedPlanningContext;
 class ProjectionEvaluatorLinkPose : public ompl::base::ProjectionEvaluator
 {
 public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   ProjectionEvaluatorLinkPose(const ModelBasedPlanningContext* pc, const std::string& link);
 
   unsigned int getDimension() const override;
@@ -63,9 +66,28 @@ public:
   void project(const ompl::base::State* state, OMPLProjection projection) const override;
 
 private:
+  /** \brief A link on the kinematic chain from the first group joint above the projected link down to that link */
+  struct ChainLink
+  {
+    const robot_model::JointModel* joint_; /**< \brief The parent joint of the link */
+    int variable_index_;                   /**< \brief Index of the joint's first variable in the OMPL state, or -1 if
+                                              the joint does not belong to the group */
+    Eigen::Isometry3d transform_;          /**< \brief The joint origin transform, including the joint transform of
+                                              joints that do not belong to the group */
+  };
+
+  /** \brief Compute the chain used to project without a full forward kinematics update.
+      Returns false if the chain contains joints that need a RobotState (such as mimic joints) */
+  bool computeChain();
+
   const ModelBasedPlanningContext* planning_context_;
   const robot_model::LinkModel* link_;
   TSStateStorage tss_;
+
+  bool use_chain_;               /**< \brief Whether the projection is computed from chain_ */
+  Eigen::Isometry3d chain_base_; /**< \brief Global pose of the parent of the first chain link */
+  std::vector<ChainLink, Eigen::aligned_allocator<ChainLink> > chain_; /**< \brief The chain, ordered from the group
+                                                                         joint down to the projected link */
 };
 
 /** @class ProjectionEvaluatorJointValue
@@ -268,6 +268,24 @@ protected:
 
   double tag_snap_to_segment_;
   double tag_snap_to_segment_complement_;
+
+private:
+  /** \brief Check whether the group consists only of single-variable revolute/prismatic joints and if so, set up the
+      data for the vectorized distance and interpolation kernels */
+  void configureSimpleJointKernels();
+
+  /** \brief Interpolate the group values when simple_joint_kernels_ is set */
+  void interpolateSimpleJoints(const double* from, const double* to, const double t, double* state) const;
+
+  /** \brief True if distance() and interpolate() can use the kernels below instead of the JointModelGroup */
+  bool simple_joint_kernels_;
+
+  /** \brief The distance factor of each variable, zero for continuous joints (they are handled separately) */
+  Eigen::VectorXd variable_distance_weights_;
+
+  /** \brief Indices of the variables of continuous revolute joints and their distance factors */
+  std::vector<unsigned int> continuous_variables_;
+  std::vector<double> continuous_distance_weights_;
 };
 }  // namespace ompl_interface
 
@@ -120,6 +120,16 @@ private:
     bool computeStateFK(StateType* full_state, unsigned int idx) const;
     bool computeStateIK(StateType* full_state, unsigned int idx) const;
 
+    /** \brief Check whether forward kinematics of the joint values in \e full_state reaches the pose stored at \e idx
+        within the given tolerances. If it does, the stored pose is replaced by the forward kinematics result, so it
+        agrees exactly with the joint values */
+    bool snapPoseToJoints(StateType* full_state, unsigned int idx, double position_tolerance,
+                          double orientation_tolerance) const;
+
+    /** \brief Compute the pose of the tip link for the joint values in \e full_state. The result lives in a
+        thread-local buffer that is valid until the next kinematics call of this thread */
+    const geometry_msgs::Pose* computeFK(const StateType* full_state) const;
+
     bool operator<(const PoseComponent& o) const
     {
       return subgroup_->getName() < o.subgroup_->getName();
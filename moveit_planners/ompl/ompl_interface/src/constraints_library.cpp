@@ -504,7 +504,7 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
 
     ss->sampleUniform(temp.get());
     pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, temp.get());
-    if (kset.decide(robot_state).satisfied)
+    if (kset.satisfies(robot_state))
     {
       if (sstor->size() < options.samples)
       {
@@ -569,7 +569,7 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
           double this_step = step / (1.0 - (k - 1) * step);
           space->interpolate(int_states[k - 1], sj, this_step, int_states[k]);
           pcontext->getOMPLStateSpace()->copyToRobotState(robot_state, int_states[k]);
-          if (!kset.decide(robot_state).satisfied)
+          if (!kset.satisfies(robot_state))
           {
             ok = false;
             break;
@@ -127,7 +127,7 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       if (constraint_sampler_->project(work_state_, planning_context_->getMaximumStateSamplingAttempts()))
       {
         work_state_.update();
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
+        if (kinematic_constraint_set_->satisfies(work_state_, verbose))
         {
           if (checkStateValidity(new_goal, work_state_, verbose))
             return true;
@@ -151,7 +151,7 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       if (static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(new_goal, verbose))
       {
         planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, new_goal);
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
+        if (kinematic_constraint_set_->satisfies(work_state_, verbose))
           return true;
       }
     }
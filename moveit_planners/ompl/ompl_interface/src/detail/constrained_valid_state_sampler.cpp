@@ -63,7 +63,7 @@ bool ompl_interface::ValidConstrainedSampler::project(ompl::base::State* state)
     planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, state);
     if (constraint_sampler_->project(work_state_, planning_context_->getMaximumStateSamplingAttempts()))
     {
-      if (kinematic_constraint_set_->decide(work_state_).satisfied)
+      if (kinematic_constraint_set_->satisfies(work_state_))
       {
         planning_context_->getOMPLStateSpace()->copyToOMPLState(state, work_state_);
         return true;
@@ -81,7 +81,7 @@ bool ompl_interface::ValidConstrainedSampler::sample(ob::State* state)
     if (constraint_sampler_->sample(work_state_, planning_context_->getCompleteInitialRobotState(),
                                     planning_context_->getMaximumStateSamplingAttempts()))
     {
-      if (kinematic_constraint_set_->decide(work_state_).satisfied)
+      if (kinematic_constraint_set_->satisfies(work_state_))
       {
         planning_context_->getOMPLStateSpace()->copyToOMPLState(state, work_state_);
         return true;
@@ -92,7 +92,7 @@ bool ompl_interface::ValidConstrainedSampler::sample(ob::State* state)
   {
     default_sampler_->sampleUniform(state);
     planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, state);
-    if (kinematic_constraint_set_->decide(work_state_).satisfied)
+    if (kinematic_constraint_set_->satisfies(work_state_))
       return true;
   }
 
@@ -110,7 +110,7 @@ bool ompl_interface::ValidConstrainedSampler::sampleNear(ompl::base::State* stat
     double dist = pow(rng_.uniform01(), inv_dim_) * distance;
     si_->getStateSpace()->interpolate(near, state, dist / total_d, state);
     planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, state);
-    if (!kinematic_constraint_set_->decide(work_state_).satisfied)
+    if (!kinematic_constraint_set_->satisfies(work_state_))
       return false;
   }
   return true;
@@ -46,7 +46,63 @@ ompl_interface::ProjectionEvaluatorLinkPose::ProjectionEvaluatorLinkPose(const M
   , planning_context_(pc)
   , link_(planning_context_->getJointModelGroup()->getLinkModel(link))
   , tss_(planning_context_->getCompleteInitialRobotState())
+  , use_chain_(false)
+  , chain_base_(Eigen::Isometry3d::Identity())
 {
+  if (link_)
+    use_chain_ = computeChain();
+}
+
+bool ompl_interface::ProjectionEvaluatorLinkPose::computeChain()
+{
+  const robot_model::JointModelGroup* jmg = planning_context_->getJointModelGroup();
+  robot_state::RobotState initial_state(planning_context_->getCompleteInitialRobotState());
+  initial_state.update();
+
+  // links from the projected link up to the root; everything above the topmost link moved by a group joint
+  // keeps the pose it has in the initial state
+  std::vector<const robot_model::LinkModel*> links;
+  std::size_t top = 0;
+  bool moved = false;
+  for (const robot_model::LinkModel* link = link_; link; link = link->getParentLinkModel())
+  {
+    links.push_back(link);
+    if (jmg->hasJointModel(link->getParentJointModel()->getName()))
+    {
+      top = links.size() - 1;
+      moved = true;
+    }
+  }
+  if (!moved)
+  {
+    chain_base_ = initial_state.getGlobalLinkTransform(link_);
+    return true;
+  }
+
+  const robot_model::LinkModel* top_parent = links[top]->getParentLinkModel();
+  chain_base_ = top_parent ? initial_state.getGlobalLinkTransform(top_parent) : Eigen::Isometry3d::Identity();
+  for (std::size_t i = top + 1; i-- > 0;)
+  {
+    const robot_model::LinkModel* link = links[i];
+    const robot_model::JointModel* joint = link->getParentJointModel();
+    ChainLink chain_link;
+    chain_link.joint_ = joint;
+    chain_link.transform_ = link->getJointOriginTransform();
+    chain_link.variable_index_ = -1;
+    if (jmg->hasJointModel(joint->getName()) && joint->getVariableCount() > 0)
+    {
+      // mimic joints get their values from other joints, which only RobotState knows about
+      if (joint->getMimic())
+        return false;
+      chain_link.variable_index_ = jmg->getVariableGroupIndex(joint->getVariableNames()[0]);
+      if (chain_link.variable_index_ < 0)
+        return false;
+    }
+    else
+      chain_link.transform_ = chain_link.transform_ * initial_state.getJointTransform(joint);
+    chain_.push_back(chain_link);
+  }
+  return true;
 }
 
 unsigned int ompl_interface::ProjectionEvaluatorLinkPose::getDimension() const
@@ -65,6 +121,28 @@ void ompl_interface::ProjectionEvaluatorLinkPose::defaultCellSizes()
 void ompl_interface::ProjectionEvaluatorLinkPose::project(const ompl::base::State* state,
                                                           OMPLProjection projection) const
 {
+  if (use_chain_)
+  {
+    // only the transforms on the chain from the group to link_ are computed, directly from the OMPL state
+    const double* values = state->as<ModelBasedStateSpace::StateType>()->values;
+    Eigen::Isometry3d pose = chain_base_;
+    Eigen::Isometry3d joint_transform;
+    for (const ChainLink& chain_link : chain_)
+    {
+      if (chain_link.variable_index_ < 0)
+        pose = pose * chain_link.transform_;
+      else
+      {
+        chain_link.joint_->computeTransform(values + chain_link.variable_index_, joint_transform);
+        pose = pose * chain_link.transform_ * joint_transform;
+      }
+    }
+    projection(0) = pose.translation().x();
+    projection(1) = pose.translation().y();
+    projection(2) = pose.translation().z();
+    return;
+  }
+
   robot_state::RobotState* s = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
 
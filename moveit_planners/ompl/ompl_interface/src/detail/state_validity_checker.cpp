@@ -125,7 +125,7 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*robot_state, verbose).satisfied)
+  if (kset && !kset->satisfies(*robot_state, verbose))
     return false;
 
   // check feasibility
@@ -197,7 +197,7 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*robot_state, verbose).satisfied)
+  if (kset && !kset->satisfies(*robot_state, verbose))
   {
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
     return false;
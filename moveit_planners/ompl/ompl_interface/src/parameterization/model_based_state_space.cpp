@@ -35,10 +35,12 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <boost/math/constants/constants.hpp>
 #include <utility>
 
 ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(ModelBasedStateSpaceSpecification spec)
-  : ompl::base::StateSpace(), spec_(std::move(spec))
+  : ompl::base::StateSpace(), spec_(std::move(spec)), simple_joint_kernels_(false)
 {
   // set the state space name
   setName(spec_.joint_model_group_->getName());
@@ -67,6 +69,8 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(ModelBasedStateSpaceS
     spec_.joint_bounds_[i] = &joint_bounds_storage_[i];
   }
 
+  configureSimpleJointKernels();
+
   // default settings
   setTagSnapToSegment(0.95);
 
@@ -78,6 +82,42 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(ModelBasedStateSpaceS
 
 ompl_interface::ModelBasedStateSpace::~ModelBasedStateSpace() = default;
 
+void ompl_interface::ModelBasedStateSpace::configureSimpleJointKernels()
+{
+  // the kernels operate on the values array directly, so every variable has to belong to an active, single-variable
+  // revolute or prismatic joint, stored at the index matching the joint's position in the group
+  if (!spec_.joint_model_group_->getMimicJointModels().empty() || joint_model_vector_.size() != variable_count_)
+    return;
+
+  Eigen::VectorXd weights(variable_count_);
+  std::vector<unsigned int> continuous_variables;
+  std::vector<double> continuous_weights;
+  for (std::size_t i = 0; i < joint_model_vector_.size(); ++i)
+  {
+    const robot_model::JointModel* joint = joint_model_vector_[i];
+    if (joint->getVariableCount() != 1 ||
+        spec_.joint_model_group_->getVariableGroupIndex(joint->getVariableNames()[0]) != static_cast<int>(i))
+      return;
+    if (joint->getType() == robot_model::JointModel::REVOLUTE &&
+        static_cast<const robot_model::RevoluteJointModel*>(joint)->isContinuous())
+    {
+      weights[i] = 0.0;
+      continuous_variables.push_back(i);
+      continuous_weights.push_back(joint->getDistanceFactor());
+    }
+    else if (joint->getType() == robot_model::JointModel::REVOLUTE ||
+             joint->getType() == robot_model::JointModel::PRISMATIC)
+      weights[i] = joint->getDistanceFactor();
+    else
+      return;
+  }
+
+  variable_distance_weights_ = weights;
+  continuous_variables_ = continuous_variables;
+  continuous_distance_weights_ = continuous_weights;
+  simple_joint_kernels_ = true;
+}
+
 double ompl_interface::ModelBasedStateSpace::getTagSnapToSegment() const
 {
   return tag_snap_to_segment_;
@@ -168,6 +208,24 @@ double ompl_interface::ModelBasedStateSpace::distance(const ompl::base::State* s
 {
   if (distance_function_)
     return distance_function_(state1, state2);
+  else if (simple_joint_kernels_)
+  {
+    const double* values1 = state1->as<StateType>()->values;
+    const double* values2 = state2->as<StateType>()->values;
+    Eigen::Map<const Eigen::VectorXd> v1(values1, variable_count_);
+    Eigen::Map<const Eigen::VectorXd> v2(values2, variable_count_);
+    // weighted L1 distance over all bounded joints; continuous joints have zero weight here
+    double d = variable_distance_weights_.cwiseProduct((v1 - v2).cwiseAbs()).sum();
+    for (std::size_t i = 0; i < continuous_variables_.size(); ++i)
+    {
+      const unsigned int k = continuous_variables_[i];
+      double diff = fmod(fabs(values1[k] - values2[k]), 2.0 * boost::math::constants::pi<double>());
+      if (diff > boost::math::constants::pi<double>())
+        diff = 2.0 * boost::math::constants::pi<double>() - diff;
+      d += continuous_distance_weights_[i] * diff;
+    }
+    return d;
+  }
   else
     return spec_.joint_model_group_->distance(state1->as<StateType>()->values, state2->as<StateType>()->values);
 }
@@ -202,8 +260,12 @@ void ompl_interface::ModelBasedStateSpace::interpolate(const ompl::base::State*
   if (!interpolation_function_ || !interpolation_function_(from, to, t, state))
   {
     // perform the actual interpolation
-    spec_.joint_model_group_->interpolate(from->as<StateType>()->values, to->as<StateType>()->values, t,
-                                          state->as<StateType>()->values);
+    if (simple_joint_kernels_)
+      interpolateSimpleJoints(from->as<StateType>()->values, to->as<StateType>()->values, t,
+                              state->as<StateType>()->values);
+    else
+      spec_.joint_model_group_->interpolate(from->as<StateType>()->values, to->as<StateType>()->values, t,
+                                            state->as<StateType>()->values);
 
     // compute tag
     if (from->as<StateType>()->tag >= 0 && t < 1.0 - tag_snap_to_segment_)
@@ -215,6 +277,34 @@ void ompl_interface::ModelBasedStateSpace::interpolate(const ompl::base::State*
   }
 }
 
+void ompl_interface::ModelBasedStateSpace::interpolateSimpleJoints(const double* from, const double* to, const double t,
+                                                                   double* state) const
+{
+  Eigen::Map<const Eigen::VectorXd> f(from, variable_count_);
+  Eigen::Map<const Eigen::VectorXd> g(to, variable_count_);
+  Eigen::Map<Eigen::VectorXd> s(state, variable_count_);
+  s = f + t * (g - f);
+
+  // continuous joints take the shorter way around the circle (same as RevoluteJointModel::interpolate())
+  for (unsigned int k : continuous_variables_)
+  {
+    double diff = to[k] - from[k];
+    if (fabs(diff) > boost::math::constants::pi<double>())
+    {
+      if (diff > 0.0)
+        diff = 2.0 * boost::math::constants::pi<double>() - diff;
+      else
+        diff = -2.0 * boost::math::constants::pi<double>() - diff;
+      state[k] = from[k] - diff * t;
+      // input states are within bounds, so the following check is sufficient
+      if (state[k] > boost::math::constants::pi<double>())
+        state[k] -= 2.0 * boost::math::constants::pi<double>();
+      else if (state[k] < -boost::math::constants::pi<double>())
+        state[k] += 2.0 * boost::math::constants::pi<double>();
+    }
+  }
+}
+
 double* ompl_interface::ModelBasedStateSpace::getValueAddressAtIndex(ompl::base::State* state,
                                                                      const unsigned int index) const
 {
@@ -42,6 +42,31 @@
 
 const std::string ompl_interface::PoseModelStateSpace::PARAMETERIZATION_TYPE = "PoseModel";
 
+namespace
+{
+// Buffers passed to the kinematics solvers. Interpolation runs in planner threads, so each thread keeps its own
+// buffers and they only allocate the first time they grow.
+struct KinematicsBuffers
+{
+  std::vector<double> values_;
+  std::vector<double> solution_;
+  std::vector<geometry_msgs::Pose> poses_;
+};
+
+KinematicsBuffers& getKinematicsBuffers()
+{
+  static thread_local KinematicsBuffers buffers;
+  return buffers;
+}
+
+// Interpolated states whose joint values already reach the interpolated poses within these tolerances keep their
+// joint values and take the pose computed by forward kinematics, instead of running IK. Pose and joints of the state
+// then agree exactly, and the pose deviates from the Cartesian interpolation by at most 0.1 mm and 1 mrad, which is
+// below the repeatability of typical manipulators.
+const double IK_SKIP_POSITION_TOLERANCE = 1e-4;
+const double IK_SKIP_ORIENTATION_TOLERANCE = 1e-3;
+}  // namespace
+
 ompl_interface::PoseModelStateSpace::PoseModelStateSpace(const ModelBasedStateSpaceSpecification& spec)
   : ModelBasedStateSpace(spec)
 {
@@ -139,16 +164,17 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State* f
   // the call above may reset all flags for state; but we know the pose we want flag should be set
   state->as<StateType>()->setPoseComputed(true);
 
-  /*
-  std::cout << "*********** interpolate\n";
-  printState(from, std::cout);
-  printState(to, std::cout);
-  printState(state, std::cout);
-  std::cout << "\n\n";
-  */
-
   // after interpolation we cannot be sure about the joint values (we use them as seed only)
-  // so we recompute IK if needed
+  // so we recompute IK if needed; when forward kinematics of the interpolated joint values already
+  // reaches the interpolated poses, IK would only return the seed, so it is skipped and the poses
+  // are replaced by the forward kinematics result
+  bool joints_match_poses = true;
+  for (std::size_t i = 0; i < poses_.size() && joints_match_poses; ++i)
+    joints_match_poses = poses_[i].snapPoseToJoints(state->as<StateType>(), i, IK_SKIP_POSITION_TOLERANCE,
+                                                    IK_SKIP_ORIENTATION_TOLERANCE);
+  if (joints_match_poses)
+    state->as<StateType>()->setJointsComputed(true);
+
   if (computeStateIK(state))
   {
     double dj = jump_factor_ * ModelBasedStateSpace::distance(from, to);
@@ -189,42 +215,77 @@ ompl_interface::PoseModelStateSpace::PoseComponent::PoseComponent(
 
 bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateFK(StateType* full_state, unsigned int idx) const
 {
+  const geometry_msgs::Pose* pose = computeFK(full_state);
+  if (!pose)
+    return false;
+
+  // copy the resulting data to the desired location in the state
+  ompl::base::SE3StateSpace::StateType* se3_state = full_state->poses[idx];
+  se3_state->setXYZ(pose->position.x, pose->position.y, pose->position.z);
+  ompl::base::SO3StateSpace::StateType& so3_state = se3_state->rotation();
+  so3_state.x = pose->orientation.x;
+  so3_state.y = pose->orientation.y;
+  so3_state.z = pose->orientation.z;
+  so3_state.w = pose->orientation.w;
+
+  return true;
+}
+
+const geometry_msgs::Pose*
+ompl_interface::PoseModelStateSpace::PoseComponent::computeFK(const StateType* full_state) const
+{
+  KinematicsBuffers& buffers = getKinematicsBuffers();
+
   // read the values from the joint state, in the order expected by the kinematics solver
-  std::vector<double> values(bijection_.size());
+  buffers.values_.resize(bijection_.size());
   for (unsigned int i = 0; i < bijection_.size(); ++i)
-    values[i] = full_state->values[bijection_[i]];
+    buffers.values_[i] = full_state->values[bijection_[i]];
 
   // compute forward kinematics for the link of interest
-  std::vector<geometry_msgs::Pose> poses;
-  if (!kinematics_solver_->getPositionFK(fk_link_, values, poses))
+  if (!kinematics_solver_->getPositionFK(fk_link_, buffers.values_, buffers.poses_) || buffers.poses_.empty())
+    return nullptr;
+  return &buffers.poses_[0];
+}
+
+bool ompl_interface::PoseModelStateSpace::PoseComponent::snapPoseToJoints(StateType* full_state, unsigned int idx,
+                                                                          double position_tolerance,
+                                                                          double orientation_tolerance) const
+{
+  const geometry_msgs::Pose* pose = computeFK(full_state);
+  if (!pose)
     return false;
 
-  // copy the resulting data to the desired location in the state
   ompl::base::SE3StateSpace::StateType* se3_state = full_state->poses[idx];
-  se3_state->setXYZ(poses[0].position.x, poses[0].position.y, poses[0].position.z);
+  const double dx = pose->position.x - se3_state->getX();
+  const double dy = pose->position.y - se3_state->getY();
+  const double dz = pose->position.z - se3_state->getZ();
+  if (dx * dx + dy * dy + dz * dz > position_tolerance * position_tolerance)
+    return false;
+
   ompl::base::SO3StateSpace::StateType& so3_state = se3_state->rotation();
-  so3_state.x = poses[0].orientation.x;
-  so3_state.y = poses[0].orientation.y;
-  so3_state.z = poses[0].orientation.z;
-  so3_state.w = poses[0].orientation.w;
+  const Eigen::Quaterniond q1(so3_state.w, so3_state.x, so3_state.y, so3_state.z);
+  const Eigen::Quaterniond q2(pose->orientation.w, pose->orientation.x, pose->orientation.y, pose->orientation.z);
+  if (q1.angularDistance(q2) > orientation_tolerance)
+    return false;
 
+  se3_state->setXYZ(pose->position.x, pose->position.y, pose->position.z);
+  so3_state.x = pose->orientation.x;
+  so3_state.y = pose->orientation.y;
+  so3_state.z = pose->orientation.z;
+  so3_state.w = pose->orientation.w;
   return true;
 }
 
 bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateType* full_state, unsigned int idx) const
 {
+  KinematicsBuffers& buffers = getKinematicsBuffers();
+
   // read the values from the joint state, in the order expected by the kinematics solver; use these as the seed
-  std::vector<double> seed_values(bijection_.size());
+  std::vector<double>& seed_values = buffers.values_;
+  seed_values.resize(bijection_.size());
   for (std::size_t i = 0; i < bijection_.size(); ++i)
     seed_values[i] = full_state->values[bijection_[i]];
 
-  /*
-  std::cout << "seed: ";
-  for (std::size_t i = 0 ; i < seed_values.size() ; ++i)
-    std::cout << seed_values[i] << " ";
-  std::cout << std::endl;
-  */
-
   // construct the pose
   geometry_msgs::Pose pose;
   const ompl::base::SE3StateSpace::StateType* se3_state = full_state->poses[idx];
@@ -238,7 +299,8 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   pose.orientation.w = so3_state.w;
 
   // run IK
-  std::vector<double> solution(bijection_.size());
+  std::vector<double>& solution = buffers.solution_;
+  solution.resize(bijection_.size());
   moveit_msgs::MoveItErrorCodes err_code;
   if (!kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code))
   {
@@ -344,8 +406,4 @@ void ompl_interface::PoseModelStateSpace::copyToOMPLState(ompl::base::State* sta
   state->as<StateType>()->setJointsComputed(true);
   state->as<StateType>()->setPoseComputed(false);
   computeStateFK(state);
-  /*
-  std::cout << "COPY STATE IN:\n";
-  printState(state, std::cout);
-  std::cout << "---------- COPY STATE IN\n"; */
 }
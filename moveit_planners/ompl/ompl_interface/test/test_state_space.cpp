@@ -36,16 +36,149 @@
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+#include <moveit/ompl_interface/detail/projection_evaluators.h>
+#include <moveit/kinematics_base/kinematics_base.h>
 
 #include <urdf_parser/urdf_parser.h>
 
 #include <ompl/util/Exception.h>
+#include <ompl/geometric/SimpleSetup.h>
 #include <moveit/robot_state/conversions.h>
 #include <gtest/gtest.h>
 #include <fstream>
 #include <boost/filesystem/path.hpp>
 #include <ros/package.h>
 
+/** \brief Numerical IK for a chain group, iterating on the Jacobian of the tip link from the seed. It counts the IK
+    queries so tests can tell whether IK was run */
+class JacobianKinematics : public kinematics::KinematicsBase
+{
+public:
+  JacobianKinematics(const robot_model::RobotModelConstPtr& robot_model, const robot_model::JointModelGroup* group,
+                     const std::string& tip)
+    : model_(robot_model), group_(group), tip_(robot_model->getLinkModel(tip)), ik_calls_(0)
+  {
+    storeValues(*robot_model, group->getName(), robot_model->getModelFrame(), { tip }, DEFAULT_SEARCH_DISCRETIZATION);
+  }
+
+  std::size_t getIKCallCount() const
+  {
+    return ik_calls_;
+  }
+
+  bool getPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                     std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
+                     const kinematics::KinematicsQueryOptions& /*options*/) const override
+  {
+    ++ik_calls_;
+    const Eigen::Vector3d target_position(ik_pose.position.x, ik_pose.position.y, ik_pose.position.z);
+    const Eigen::Matrix3d target_rotation = Eigen::Quaterniond(ik_pose.orientation.w, ik_pose.orientation.x,
+                                                               ik_pose.orientation.y, ik_pose.orientation.z)
+                                                .normalized()
+                                                .toRotationMatrix();
+
+    robot_state::RobotState state(model_);
+    state.setToDefaultValues();
+    state.setJointGroupPositions(group_, ik_seed_state);
+    Eigen::MatrixXd jacobian;
+    Eigen::VectorXd error(6);
+    for (int i = 0; i < 100; ++i)
+    {
+      state.update();
+      const Eigen::Isometry3d& current = state.getGlobalLinkTransform(tip_);
+      const Eigen::AngleAxisd rotation_error(target_rotation * current.linear().transpose());
+      error.head<3>() = target_position - current.translation();
+      error.tail<3>() = rotation_error.angle() * rotation_error.axis();
+      if (error.norm() < 1e-10)
+      {
+        state.copyJointGroupPositions(group_, solution);
+        error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+        return true;
+      }
+      state.getJacobian(group_, tip_, Eigen::Vector3d::Zero(), jacobian);
+      const Eigen::MatrixXd jjt = jacobian * jacobian.transpose() + 1e-12 * Eigen::MatrixXd::Identity(6, 6);
+      Eigen::VectorXd positions;
+      state.copyJointGroupPositions(group_, positions);
+      positions += jacobian.transpose() * jjt.ldlt().solve(error);
+      state.setJointGroupPositions(group_, positions);
+    }
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double /*timeout*/, std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    return getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
+  }
+
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double /*timeout*/, const std::vector<double>& /*consistency_limits*/,
+                        std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    return getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
+  }
+
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double /*timeout*/, std::vector<double>& solution, const IKCallbackFn& /*solution_callback*/,
+                        moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    return getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
+  }
+
+  bool searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                        double /*timeout*/, const std::vector<double>& /*consistency_limits*/,
+                        std::vector<double>& solution, const IKCallbackFn& /*solution_callback*/,
+                        moveit_msgs::MoveItErrorCodes& error_code,
+                        const kinematics::KinematicsQueryOptions& options) const override
+  {
+    return getPositionIK(ik_pose, ik_seed_state, solution, error_code, options);
+  }
+
+  bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
+                     std::vector<geometry_msgs::Pose>& poses) const override
+  {
+    robot_state::RobotState state(model_);
+    state.setToDefaultValues();
+    state.setJointGroupPositions(group_, joint_angles);
+    state.update();
+    poses.resize(link_names.size());
+    for (std::size_t i = 0; i < link_names.size(); ++i)
+    {
+      const Eigen::Isometry3d& pose = state.getGlobalLinkTransform(link_names[i]);
+      const Eigen::Quaterniond q(pose.linear());
+      poses[i].position.x = pose.translation().x();
+      poses[i].position.y = pose.translation().y();
+      poses[i].position.z = pose.translation().z();
+      poses[i].orientation.x = q.x();
+      poses[i].orientation.y = q.y();
+      poses[i].orientation.z = q.z();
+      poses[i].orientation.w = q.w();
+    }
+    return true;
+  }
+
+  const std::vector<std::string>& getJointNames() const override
+  {
+    return group_->getVariableNames();
+  }
+
+  const std::vector<std::string>& getLinkNames() const override
+  {
+    return tip_frames_;
+  }
+
+private:
+  robot_model::RobotModelConstPtr model_;
+  const robot_model::JointModelGroup* group_;
+  const robot_model::LinkModel* tip_;
+  mutable std::size_t ik_calls_;
+};
+
 class LoadPlanningModelsPr2 : public testing::Test
 {
 protected:
@@ -170,6 +303,173 @@ TEST_F(LoadPlanningModelsPr2, StateSpaceCopy)
   ss.freeState(state);
 }
 
+TEST_F(LoadPlanningModelsPr2, StateSpaceDistanceInterpolate)
+{
+  // right_arm has bounded and continuous revolute joints, so it uses the specialized kernels
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::ModelBasedStateSpace ss(spec);
+  ss.setup();
+  const robot_model::JointModelGroup* jmg = ss.getJointModelGroup();
+
+  robot_state::RobotState robot_state(robot_model_);
+  ompl::base::State* from = ss.allocState();
+  ompl::base::State* to = ss.allocState();
+  ompl::base::State* state = ss.allocState();
+  std::vector<double> expected(jmg->getVariableCount());
+  for (int i = 0; i < 100; ++i)
+  {
+    robot_state.setToRandomPositions(jmg);
+    ss.copyToOMPLState(from, robot_state);
+    robot_state.setToRandomPositions(jmg);
+    ss.copyToOMPLState(to, robot_state);
+
+    const double* from_values = from->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+    const double* to_values = to->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+    EXPECT_NEAR(jmg->distance(from_values, to_values), ss.distance(from, to), 1e-12);
+
+    for (double t = 0.0; t <= 1.0; t += 0.25)
+    {
+      jmg->interpolate(from_values, to_values, t, &expected[0]);
+      ss.interpolate(from, to, t, state);
+      for (std::size_t j = 0; j < expected.size(); ++j)
+        EXPECT_NEAR(expected[j], state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values[j], 1e-12);
+    }
+  }
+
+  ss.freeState(from);
+  ss.freeState(to);
+  ss.freeState(state);
+}
+
+TEST_F(LoadPlanningModelsPr2, LinkPoseProjection)
+{
+  ompl_interface::ModelBasedStateSpaceSpecification space_spec(robot_model_, "right_arm");
+  ompl_interface::ModelBasedPlanningContextSpecification spec;
+  spec.state_space_.reset(new ompl_interface::JointModelStateSpace(space_spec));
+  spec.state_space_->setup();
+  spec.ompl_simple_setup_.reset(new ompl::geometric::SimpleSetup(spec.state_space_));
+  ompl_interface::ModelBasedPlanningContext context("right_arm", spec);
+
+  // joints outside of the group (such as the torso) are taken from the initial state
+  robot_state::RobotState initial_state(robot_model_);
+  initial_state.setToRandomPositions();
+  initial_state.update();
+  context.setCompleteInitialState(initial_state);
+
+  ompl::base::StateSamplerPtr sampler = spec.state_space_->allocDefaultStateSampler();
+  ompl::base::State* state = spec.state_space_->allocState();
+  robot_state::RobotState robot_state(initial_state);
+  for (const std::string& link : { "r_shoulder_pan_link", "r_forearm_link", "r_wrist_roll_link" })
+  {
+    ompl_interface::ProjectionEvaluatorLinkPose evaluator(&context, link);
+    ASSERT_EQ(evaluator.getDimension(), 3u);
+    ompl::base::EuclideanProjection projection(3);
+    for (int i = 0; i < 100; ++i)
+    {
+      sampler->sampleUniform(state);
+      evaluator.project(state, projection);
+
+      // the projection previously computed through a full RobotState update
+      spec.state_space_->copyToRobotState(robot_state, state);
+      robot_state.update();
+      const Eigen::Vector3d& expected = robot_state.getGlobalLinkTransform(link).translation();
+      EXPECT_NEAR(projection(0), expected.x(), 1e-9) << link;
+      EXPECT_NEAR(projection(1), expected.y(), 1e-9) << link;
+      EXPECT_NEAR(projection(2), expected.z(), 1e-9) << link;
+    }
+  }
+  spec.state_space_->freeState(state);
+}
+
+TEST_F(LoadPlanningModelsPr2, PoseModelInterpolationSkipsIK)
+{
+  robot_model::JointModelGroup* jmg = robot_model_->getJointModelGroup("right_arm");
+  auto solver = std::make_shared<JacobianKinematics>(robot_model_, jmg, "r_wrist_roll_link");
+  jmg->setSolverAllocators([solver](const robot_model::JointModelGroup*) { return solver; });
+
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::PoseModelStateSpace ss(spec);
+  ss.setPlanningVolume(-2, 2, -2, 2, -2, 2);
+  ss.setup();
+
+  robot_state::RobotState robot_state(robot_model_);
+  robot_state.setToDefaultValues();
+  robot_state.setVariablePosition("r_shoulder_pan_joint", 0.3);
+  robot_state.setVariablePosition("r_shoulder_lift_joint", 0.2);
+  robot_state.setVariablePosition("r_upper_arm_roll_joint", -0.5);
+  robot_state.setVariablePosition("r_elbow_flex_joint", -1.0);
+  robot_state.setVariablePosition("r_forearm_roll_joint", 0.4);
+  robot_state.setVariablePosition("r_wrist_flex_joint", -0.8);
+  robot_state.setVariablePosition("r_wrist_roll_joint", 0.1);
+
+  typedef ompl_interface::PoseModelStateSpace::StateType StateType;
+  ompl::base::State* from = ss.allocState();
+  ompl::base::State* to = ss.allocState();
+  ompl::base::State* skipped = ss.allocState();
+  ompl::base::State* solved = ss.allocState();
+  ss.copyToOMPLState(from, robot_state);
+
+  ompl::base::SE3StateSpace se3;
+  const double position_tolerance = 1e-4;
+  const double orientation_tolerance = 1e-3;
+
+  // rolling the wrist turns the tip about its own axis, so the joint space interpolation already reaches the
+  // Cartesian interpolation and IK is skipped
+  robot_state.setVariablePosition("r_wrist_roll_joint", 0.7);
+  ss.copyToOMPLState(to, robot_state);
+  for (double t = 0.25; t < 1.0; t += 0.25)
+  {
+    std::size_t ik_calls = solver->getIKCallCount();
+    ss.interpolate(from, to, t, skipped);
+    EXPECT_EQ(ik_calls, solver->getIKCallCount());
+    ASSERT_FALSE(skipped->as<StateType>()->isValidityKnown());
+
+    // the same interpolation with IK
+    ss.copyState(solved, skipped);
+    se3.interpolate(from->as<StateType>()->poses[0], to->as<StateType>()->poses[0], t,
+                    solved->as<StateType>()->poses[0]);
+    solved->as<StateType>()->setJointsComputed(false);
+    ASSERT_TRUE(ss.computeStateIK(solved));
+    EXPECT_EQ(ik_calls + 1, solver->getIKCallCount());
+
+    for (std::size_t i = 0; i < jmg->getVariableCount(); ++i)
+      EXPECT_NEAR(skipped->as<StateType>()->values[i], solved->as<StateType>()->values[i], 1e-3);
+    const ompl::base::SE3StateSpace::StateType* skipped_pose = skipped->as<StateType>()->poses[0];
+    const ompl::base::SE3StateSpace::StateType* solved_pose = solved->as<StateType>()->poses[0];
+    EXPECT_NEAR(skipped_pose->getX(), solved_pose->getX(), position_tolerance);
+    EXPECT_NEAR(skipped_pose->getY(), solved_pose->getY(), position_tolerance);
+    EXPECT_NEAR(skipped_pose->getZ(), solved_pose->getZ(), position_tolerance);
+    EXPECT_LE(se3.getSubspace(1)->distance(&skipped_pose->rotation(), &solved_pose->rotation()),
+              orientation_tolerance);
+
+    // the pose of the skipped state is the forward kinematics of its joint values
+    ss.copyToRobotState(robot_state, skipped);
+    robot_state.update();
+    const Eigen::Isometry3d& tip = robot_state.getGlobalLinkTransform("r_wrist_roll_link");
+    EXPECT_NEAR(tip.translation().x(), skipped_pose->getX(), 1e-9);
+    EXPECT_NEAR(tip.translation().y(), skipped_pose->getY(), 1e-9);
+    EXPECT_NEAR(tip.translation().z(), skipped_pose->getZ(), 1e-9);
+    const Eigen::Quaterniond q(tip.linear());
+    const ompl::base::SO3StateSpace::StateType& rotation = skipped_pose->rotation();
+    EXPECT_NEAR(1.0, std::fabs(q.w() * rotation.w + q.x() * rotation.x + q.y() * rotation.y + q.z() * rotation.z),
+                1e-9);
+  }
+
+  // flexing the elbow moves the tip along an arc, so IK is needed
+  ss.copyToRobotState(robot_state, from);
+  robot_state.setVariablePosition("r_elbow_flex_joint", -1.4);
+  ss.copyToOMPLState(to, robot_state);
+  std::size_t ik_calls = solver->getIKCallCount();
+  ss.interpolate(from, to, 0.5, solved);
+  EXPECT_EQ(ik_calls + 1, solver->getIKCallCount());
+  ASSERT_FALSE(solved->as<StateType>()->isValidityKnown());
+
+  ss.freeState(from);
+  ss.freeState(to);
+  ss.freeState(skipped);
+  ss.freeState(solved);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -61,6 +61,7 @@ private:
   volatile bool running;
 
   void search(int, int, int volatile*, int*, int&, int&);
+  void waitForSearch();
   inline int getNode(int, int, int);
 
 public:
@@ -71,6 +72,7 @@ public:
 
   void setWall(int, int, int);
   bool isWall(int, int, int);
+  void clearWalls();
 
   void run(int, int, int);
 
@@ -56,24 +56,42 @@
 #include <sbpl_interface/environment_chain3d_types.h>
 #include <moveit_msgs/GetMotionPlan.h>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 #include <Eigen/Core>
 
 static const double DEFAULT_INTERPOLATION_DISTANCE = .05;
 static const double DEFAULT_JOINT_MOTION_PRIMITIVE_DISTANCE = .2;
+static const std::size_t DEFAULT_MAX_INTERPOLATION_CACHE_SIZE = 64 * 1024 * 1024;
 
 namespace sbpl_interface
 {
 struct PlanningStatistics
 {
-  PlanningStatistics() : total_expansions_(0), coll_checks_(0)
+  PlanningStatistics()
+    : total_expansions_(0), coll_checks_(0), cached_interpolations_(0), uncached_interpolations_(0), bfs_reused_(false)
   {
   }
 
+  /** \brief Number of successor expansions per second of expansion time (0 if nothing was expanded) */
+  double getExpansionsPerSecond() const
+  {
+    double t = total_expansion_time_.toSec();
+    return t > 0.0 ? total_expansions_ / t : 0.0;
+  }
+
   unsigned int total_expansions_;
   ros::WallDuration total_expansion_time_;
   ros::WallDuration total_coll_check_time_;
   unsigned int coll_checks_;
   ros::WallDuration total_planning_time_;
+
+  /// number of interpolated segments kept in the interpolation cache
+  unsigned int cached_interpolations_;
+  /// number of segments that were not cached because the cache was full
+  unsigned int uncached_interpolations_;
+  /// true if the BFS heuristic grid of a previous plan was reused
+  bool bfs_reused_;
 };
 
 struct PlanningParameters
@@ -84,6 +102,7 @@ struct PlanningParameters
     , attempt_full_shortcut_(true)
     , interpolation_distance_(DEFAULT_INTERPOLATION_DISTANCE)
     , joint_motion_primitive_distance_(DEFAULT_JOINT_MOTION_PRIMITIVE_DISTANCE)
+    , max_interpolation_cache_size_(DEFAULT_MAX_INTERPOLATION_CACHE_SIZE)
   {
   }
 
@@ -92,6 +111,28 @@ struct PlanningParameters
   bool attempt_full_shortcut_;
   double interpolation_distance_;
   double joint_motion_primitive_distance_;
+
+  /// upper bound (in bytes) on the joint values stored for interpolated segments; segments
+  /// beyond the bound are regenerated when the trajectory is assembled
+  std::size_t max_interpolation_cache_size_;
+};
+
+/** \brief The BFS heuristic grid together with the occupancy it was computed for.
+
+    The grid can be handed from one EnvironmentChain3D to the next so that the breadth first
+    search is only repeated when the goal cell or the occupied cells change. */
+struct BFSHeuristicCache
+{
+  BFSHeuristicCache()
+  {
+    goal_xyz_[0] = goal_xyz_[1] = goal_xyz_[2] = -1;
+  }
+
+  /// protects the members below; environments of concurrent plans may share the cache
+  boost::mutex lock_;
+  boost::shared_ptr<BFS_3D> bfs_;
+  std::vector<bool> walls_;
+  int goal_xyz_[3];
 };
 
 /** Environment to be used when planning for a Robotic Arm using the SBPL. */
@@ -219,8 +260,8 @@ public:
     return planning_data_;
   }
 
-  bool populateTrajectoryFromStateIDSequence(const std::vector<int>& state_ids,
-                                             trajectory_msgs::JointTrajectory& traj) const;
+  /** \brief Not const: segments that were not cached are regenerated with the interpolation states */
+  bool populateTrajectoryFromStateIDSequence(const std::vector<int>& state_ids, trajectory_msgs::JointTrajectory& traj);
 
   const PlanningStatistics& getPlanningStatistics() const
   {
@@ -229,6 +270,12 @@ public:
 
   bool getPlaneBFSMarker(visualization_msgs::Marker& plane_marker, double z_val);
 
+  /** \brief Share a BFS heuristic grid with other environments. Must be called before setupForMotionPlan() */
+  void setBFSHeuristicCache(const boost::shared_ptr<BFSHeuristicCache>& cache)
+  {
+    bfs_cache_ = cache;
+  }
+
   const Eigen::Isometry3d& getGoalPose() const
   {
     return goal_pose_;
@@ -243,8 +290,11 @@ protected:
 
   planning_scene::PlanningSceneConstPtr planning_scene_;
 
+  bool setupBFS(const int (&goal_xyz)[3]);
+
   double angle_discretization_;
-  BFS_3D* bfs_;
+  boost::shared_ptr<BFS_3D> bfs_;
+  boost::shared_ptr<BFSHeuristicCache> bfs_cache_;
 
   std::vector<boost::shared_ptr<JointMotionWrapper> > joint_motion_wrappers_;
   std::vector<boost::shared_ptr<JointMotionPrimitive> > possible_actions_;
@@ -270,7 +320,8 @@ protected:
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_1_;
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_2_;
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_temp_;
-  std::map<int, std::map<int, std::vector<std::vector<double> > > > generated_interpolations_map_;
+  boost::unordered_map<std::pair<int, int>, std::vector<std::vector<double> > > generated_interpolations_map_;
+  std::size_t generated_interpolations_size_;
 
   void setMotionPrimitives(const std::string& group_name);
   void determineMaximumEndEffectorTravel();
@@ -296,6 +347,16 @@ protected:
   bool interpolateAndCollisionCheck(const std::vector<double> angles1, const std::vector<double> angles2,
                                     std::vector<std::vector<double> >& state_values);
 
+  /** \brief Store the interpolated segment between two states, unless the cache is full */
+  void cacheInterpolation(int from_state_ID, int to_state_ID, const std::vector<std::vector<double> >& state_values);
+
+  /** \brief Get the interpolated segment between two states, regenerating it if it was not cached */
+  bool getInterpolation(int from_state_ID, int to_state_ID, std::vector<std::vector<double> >& state_values);
+
+  /** \brief Interpolate between two sets of joint values without collision checking */
+  void interpolate(const std::vector<double>& angles1, const std::vector<double>& angles2,
+                   std::vector<std::vector<double> >& state_values);
+
   inline double getEuclideanDistance(double x1, double y1, double z1, double x2, double y2, double z2) const
   {
     return sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2) + (z1 - z2) * (z1 - z2));
@@ -45,7 +45,7 @@ namespace sbpl_interface
 class SBPLInterface
 {
 public:
-  SBPLInterface(const planning_models::RobotModelConstPtr& robot_model)
+  SBPLInterface(const planning_models::RobotModelConstPtr& robot_model) : bfs_cache_(new BFSHeuristicCache())
   {
   }
   virtual ~SBPLInterface()
@@ -64,6 +64,9 @@ public:
 protected:
   PlanningStatistics last_planning_statistics_;
 
+  // BFS heuristic grid kept between consecutive plans
+  boost::shared_ptr<BFSHeuristicCache> bfs_cache_;
+
   // DummyEnvironment* dummy_env_;
   // SBPLPlanner *planner_;
 };
@@ -61,13 +61,18 @@ void BFS_3D::getDimensions(int* width, int* height, int* length)
   *length = dim_z - 2;
 }
 
-void BFS_3D::setWall(int x, int y, int z)
+void BFS_3D::waitForSearch()
 {
-  if (running)
+  if (search_thread_)
   {
-    // error "Cannot modify grid while search is running"
-    return;
+    search_thread_->join();
+    search_thread_.reset();
   }
+}
+
+void BFS_3D::setWall(int x, int y, int z)
+{
+  waitForSearch();
 
   int node = getNode(x, y, z);
   distance_grid[node] = WALL;
@@ -79,13 +84,24 @@ bool BFS_3D::isWall(int x, int y, int z)
   return distance_grid[node] == WALL;
 }
 
-void BFS_3D::run(int x, int y, int z)
+void BFS_3D::clearWalls()
 {
-  if (running)
+  waitForSearch();
+
+  for (int node = 0; node < dim_xyz; node++)
   {
-    // error "Search already running"
-    return;
+    int x = node % dim_x, y = node / dim_x % dim_y, z = node / dim_xy;
+    if (x == 0 || x == dim_x - 1 || y == 0 || y == dim_y - 1 || z == 0 || z == dim_z - 1)
+      distance_grid[node] = WALL;
+    else
+      distance_grid[node] = UNDISCOVERED;
   }
+}
+
+void BFS_3D::run(int x, int y, int z)
+{
+  // a grid can be searched again for a new goal, so let a previous search finish first
+  waitForSearch();
 
   for (int i = 0; i < dim_xyz; i++)
     if (distance_grid[i] != WALL)
@@ -49,7 +49,6 @@ namespace sbpl_interface
 {
 EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstPtr& planning_scene)
   : planning_scene_(planning_scene)
-  , bfs_(NULL)
   , state_(planning_scene->getCurrentState())
   , planning_data_(StateID2IndexMapping)
   , goal_constraint_set_(planning_scene->getRobotModel(), planning_scene->getTransforms())
@@ -57,16 +56,13 @@ EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstP
   , interpolation_state_1_(planning_scene->getCurrentState())
   , interpolation_state_2_(planning_scene->getCurrentState())
   , interpolation_state_temp_(planning_scene->getCurrentState())
+  , generated_interpolations_size_(0)
   , closest_to_goal_(DBL_MAX)
 {
 }
 
 EnvironmentChain3D::~EnvironmentChain3D()
 {
-  if (bfs_ != NULL)
-  {
-    delete bfs_;
-  }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -312,7 +308,7 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
       {
         // std::cerr << "Interpolation generated from id " << source_state_ID << " is " << interpolated_values.size() <<
         // " states\n";
-        generated_interpolations_map_[source_state_ID][planning_data_.goal_hash_entry_->stateID] = interpolated_values;
+        cacheInterpolation(source_state_ID, planning_data_.goal_hash_entry_->stateID, interpolated_values);
         succ_hash_entry = planning_data_.goal_hash_entry_;
         succ_is_goal_state = true;
       }
@@ -376,7 +372,7 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
         !succ_is_goal_state)
     {
       // std::cerr << "Adding segment from " << source_state_ID << " to " << succ_hash_entry->stateID << std::endl;
-      generated_interpolations_map_[source_state_ID][succ_hash_entry->stateID] = interpolated_values;
+      cacheInterpolation(source_state_ID, succ_hash_entry->stateID, interpolated_values);
     }
 
     // std::cerr << "Adding hash entry" << std::endl;
@@ -503,9 +499,6 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   }
   if (!planning_parameters_.use_standard_collision_checking_ && planning_parameters_.use_bfs_)
   {
-    bfs_ = new BFS_3D(gsr_->dfce_->distance_field_->getXNumCells(), gsr_->dfce_->distance_field_->getYNumCells(),
-                      gsr_->dfce_->distance_field_->getZNumCells());
-
     boost::shared_ptr<const distance_field::DistanceField> world_distance_field =
         hy_world_->getCollisionWorldDistanceField()->getDistanceField();
     if (world_distance_field->getXNumCells() != gsr_->dfce_->distance_field_->getXNumCells() ||
@@ -517,31 +510,7 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
       mres.error_code.val = moveit_msgs::MoveItErrorCodes::COLLISION_CHECKING_UNAVAILABLE;
       return false;
     }
-    // std::cerr << "BFS dimensions are "
-    //           << world_distance_field->getXNumCells() << " "
-    //           << world_distance_field->getYNumCells() << " "
-    //           << world_distance_field->getZNumCells() << std::endl;
-    unsigned int wall_count = 0;
-    for (int i = 0; i < gsr_->dfce_->distance_field_->getXNumCells() - 2; i++)
-    {
-      for (int j = 0; j < gsr_->dfce_->distance_field_->getYNumCells() - 2; j++)
-      {
-        for (int k = 0; k < gsr_->dfce_->distance_field_->getZNumCells() - 2; k++)
-        {
-          boost::this_thread::interruption_point();
-          if (gsr_->dfce_->distance_field_->getDistanceFromCell(i + 1, j + 1, k + 1) == 0.0 ||
-              world_distance_field->getDistanceFromCell(i + 1, j + 1, k + 1) == 0.0)
-          {
-            bfs_->setWall(i + 1, j + 1, k + 1);
-            wall_count++;
-          }
-        }
-      }
-    }
   }
-  // std::cerr << "Wall cells are " << wall_count << " of " <<
-  //   world_distance_field->getXNumCells()*world_distance_field->getYNumCells()*world_distance_field->getZNumCells() <<
-  //   std::endl;
 
   // setting start position
   std::vector<double> start_joint_values;
@@ -627,7 +596,11 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   // std::cerr << "Running bfs with goal " << goal_xyz[0] << " " <<  goal_xyz[1] << " " << goal_xyz[2] << std::endl;
   if (planning_parameters_.use_bfs_)
   {
-    bfs_->run(goal_xyz[0], goal_xyz[1], goal_xyz[2]);
+    if (!setupBFS(goal_xyz))
+    {
+      mres.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+      return false;
+    }
     // std::cerr << "Got start " << start_xyz[0] << " " <<  start_xyz[1] << " " << start_xyz[2] << " cost "
     //           << getBFSCostToGoal(start_xyz[0], start_xyz[1], start_xyz[2]) << std::endl;
   }
@@ -639,6 +612,98 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   return true;
 }
 
+bool EnvironmentChain3D::setupBFS(const int (&goal_xyz)[3])
+{
+  if (!bfs_cache_)
+  {
+    bfs_cache_.reset(new BFSHeuristicCache());
+  }
+
+  boost::shared_ptr<const distance_field::DistanceField> world_distance_field =
+      hy_world_->getCollisionWorldDistanceField()->getDistanceField();
+  int x_cells = gsr_->dfce_->distance_field_->getXNumCells() - 2;
+  int y_cells = gsr_->dfce_->distance_field_->getYNumCells() - 2;
+  int z_cells = gsr_->dfce_->distance_field_->getZNumCells() - 2;
+  if (x_cells <= 0 || y_cells <= 0 || z_cells <= 0)
+  {
+    ROS_WARN_STREAM("Distance field too small for BFS heuristic");
+    return false;
+  }
+
+  // scanning the occupancy is much cheaper than the 26-connected search, so the scan is
+  // used to decide whether the previous search can be kept
+  std::vector<bool> walls(x_cells * y_cells * z_cells, false);
+  for (int i = 0; i < x_cells; i++)
+  {
+    boost::this_thread::interruption_point();
+    for (int j = 0; j < y_cells; j++)
+    {
+      for (int k = 0; k < z_cells; k++)
+      {
+        if (gsr_->dfce_->distance_field_->getDistanceFromCell(i + 1, j + 1, k + 1) == 0.0 ||
+            world_distance_field->getDistanceFromCell(i + 1, j + 1, k + 1) == 0.0)
+        {
+          walls[(i * y_cells + j) * z_cells + k] = true;
+        }
+      }
+    }
+  }
+
+  boost::mutex::scoped_lock slock(bfs_cache_->lock_);
+  bool same_dimensions = false;
+  if (bfs_cache_->bfs_)
+  {
+    int w, h, l;
+    bfs_cache_->bfs_->getDimensions(&w, &h, &l);
+    same_dimensions = (w == x_cells && h == y_cells && l == z_cells);
+  }
+  bool same_walls = same_dimensions && bfs_cache_->walls_ == walls;
+  bool same_goal = bfs_cache_->goal_xyz_[0] == goal_xyz[0] && bfs_cache_->goal_xyz_[1] == goal_xyz[1] &&
+                   bfs_cache_->goal_xyz_[2] == goal_xyz[2];
+
+  if (same_walls && same_goal)
+  {
+    bfs_ = bfs_cache_->bfs_;
+    planning_statistics_.bfs_reused_ = true;
+    return true;
+  }
+
+  // a grid that is still used by the environment of another plan is replaced instead of modified
+  if (!same_dimensions || !bfs_cache_->bfs_.unique())
+  {
+    bfs_cache_->bfs_.reset(new BFS_3D(x_cells + 2, y_cells + 2, z_cells + 2));
+    same_walls = false;
+  }
+  else if (!same_walls)
+  {
+    bfs_cache_->bfs_->clearWalls();
+  }
+  if (!same_walls)
+  {
+    for (int i = 0; i < x_cells; i++)
+    {
+      for (int j = 0; j < y_cells; j++)
+      {
+        for (int k = 0; k < z_cells; k++)
+        {
+          if (walls[(i * y_cells + j) * z_cells + k])
+          {
+            bfs_cache_->bfs_->setWall(i + 1, j + 1, k + 1);
+          }
+        }
+      }
+    }
+    bfs_cache_->walls_.swap(walls);
+  }
+
+  bfs_ = bfs_cache_->bfs_;
+  bfs_->run(goal_xyz[0], goal_xyz[1], goal_xyz[2]);
+  bfs_cache_->goal_xyz_[0] = goal_xyz[0];
+  bfs_cache_->goal_xyz_[1] = goal_xyz[1];
+  bfs_cache_->goal_xyz_[2] = goal_xyz[2];
+  return true;
+}
+
 void EnvironmentChain3D::setMotionPrimitives(const std::string& group_name)
 {
   possible_actions_.clear();
@@ -903,7 +968,7 @@ bool EnvironmentChain3D::getGridXYZInt(const Eigen::Isometry3d& pose, int (&xyz)
 }
 
 bool EnvironmentChain3D::populateTrajectoryFromStateIDSequence(const std::vector<int>& state_ids,
-                                                               trajectory_msgs::JointTrajectory& traj) const
+                                                               trajectory_msgs::JointTrajectory& traj)
 {
   traj.joint_names = joint_state_group_->getJointModelGroup()->getActiveDOFNames();
   std::vector<std::vector<double> > angle_vector;
@@ -913,25 +978,10 @@ bool EnvironmentChain3D::populateTrajectoryFromStateIDSequence(const std::vector
   }
   if (planning_parameters_.interpolation_distance_ >= planning_parameters_.joint_motion_primitive_distance_)
   {
-    std::map<int, std::map<int, std::vector<std::vector<double> > > >::const_iterator it =
-        generated_interpolations_map_.find(*(state_ids.end() - 2));
     std::vector<std::vector<double> > end_points;
-    if (it != generated_interpolations_map_.end())
-    {
-      std::map<int, std::vector<std::vector<double> > >::const_iterator it2 = it->second.find(state_ids.back());
-      if (it2 == it->second.end())
-      {
-        std::cerr << "No interpolated segment connecting state id " << (*state_ids.end() - 2) << " and goal "
-                  << state_ids.back() << std::endl;
-      }
-      else
-      {
-        end_points = it2->second;
-      }
-    }
-    else
+    if (!getInterpolation(*(state_ids.end() - 2), state_ids.back(), end_points))
     {
-      std::cerr << "No interpolated segment connecting state id " << (*state_ids.end() - 2) << " and goal "
+      std::cerr << "No interpolated segment connecting state id " << *(state_ids.end() - 2) << " and goal "
                 << state_ids.back() << std::endl;
     }
     traj.points.resize(end_points.size() + angle_vector.size());
@@ -965,36 +1015,22 @@ bool EnvironmentChain3D::populateTrajectoryFromStateIDSequence(const std::vector
       //                                          INTERPOLATION_DISTANCE) << std::endl;
       //}
       traj.points.push_back(statep);
-      std::map<int, std::map<int, std::vector<std::vector<double> > > >::const_iterator it =
-          generated_interpolations_map_.find(state_ids[i]);
-      if (it != generated_interpolations_map_.end())
-      {
-        std::map<int, std::vector<std::vector<double> > >::const_iterator it2 = it->second.find(state_ids[i + 1]);
-        if (it2 == it->second.end())
-        {
-          std::cerr << "No interpolated segment connecting state id " << state_ids[i] << " and state "
-                    << state_ids[i + 1] << std::endl;
-          continue;
-        }
-        else
-        {
-          for (unsigned int j = 0; j < it2->second.size(); j++)
-          {
-            trajectory_msgs::JointTrajectoryPoint p;
-            p.positions = it2->second[j];
-            // std::cerr << "Interp " << getJointDistanceIntegerMax(traj.points.back().positions,
-            //                                                      p.positions,
-            //                                                      INTERPOLATION_DISTANCE) << std::endl;
-            traj.points.push_back(p);
-          }
-        }
-      }
-      else
+      std::vector<std::vector<double> > segment;
+      if (!getInterpolation(state_ids[i], state_ids[i + 1], segment))
       {
         std::cerr << "No interpolated segment connecting state id " << state_ids[i] << " and state " << state_ids[i + 1]
                   << std::endl;
         continue;
       }
+      for (unsigned int j = 0; j < segment.size(); j++)
+      {
+        trajectory_msgs::JointTrajectoryPoint p;
+        p.positions = segment[j];
+        // std::cerr << "Interp " << getJointDistanceIntegerMax(traj.points.back().positions,
+        //                                                      p.positions,
+        //                                                      INTERPOLATION_DISTANCE) << std::endl;
+        traj.points.push_back(p);
+      }
     }
     // last point
     trajectory_msgs::JointTrajectoryPoint statep;
@@ -1129,6 +1165,74 @@ bool EnvironmentChain3D::interpolateAndCollisionCheck(const std::vector<double>
   return true;
 }
 
+void EnvironmentChain3D::cacheInterpolation(int from_state_ID, int to_state_ID,
+                                            const std::vector<std::vector<double> >& state_values)
+{
+  std::pair<int, int> key(from_state_ID, to_state_ID);
+  std::vector<std::vector<double> >& entry = generated_interpolations_map_[key];
+  std::size_t old_size = 0;
+  for (std::size_t i = 0; i < entry.size(); i++)
+    old_size += entry[i].size() * sizeof(double);
+  std::size_t new_size = 0;
+  for (std::size_t i = 0; i < state_values.size(); i++)
+    new_size += state_values[i].size() * sizeof(double);
+
+  if (generated_interpolations_size_ - old_size + new_size > planning_parameters_.max_interpolation_cache_size_)
+  {
+    // an empty entry marks the edge as known; the segment is regenerated when the trajectory is assembled
+    generated_interpolations_size_ -= old_size;
+    std::vector<std::vector<double> >().swap(entry);
+    planning_statistics_.uncached_interpolations_++;
+    return;
+  }
+  if (old_size == 0)
+    planning_statistics_.cached_interpolations_++;
+  generated_interpolations_size_ = generated_interpolations_size_ - old_size + new_size;
+  entry = state_values;
+}
+
+bool EnvironmentChain3D::getInterpolation(int from_state_ID, int to_state_ID,
+                                          std::vector<std::vector<double> >& state_values)
+{
+  boost::unordered_map<std::pair<int, int>, std::vector<std::vector<double> > >::const_iterator it =
+      generated_interpolations_map_.find(std::make_pair(from_state_ID, to_state_ID));
+  if (it == generated_interpolations_map_.end())
+  {
+    return false;
+  }
+  if (!it->second.empty())
+  {
+    state_values = it->second;
+    return true;
+  }
+  // the segment was not stored (or is genuinely empty); it was collision checked when the edge
+  // was generated, so plain interpolation reproduces it
+  if (from_state_ID < 0 || to_state_ID < 0 || from_state_ID >= (int)planning_data_.state_ID_to_coord_table_.size() ||
+      to_state_ID >= (int)planning_data_.state_ID_to_coord_table_.size())
+  {
+    return false;
+  }
+  interpolate(planning_data_.state_ID_to_coord_table_[from_state_ID]->angles,
+              planning_data_.state_ID_to_coord_table_[to_state_ID]->angles, state_values);
+  return true;
+}
+
+void EnvironmentChain3D::interpolate(const std::vector<double>& angles1, const std::vector<double>& angles2,
+                                     std::vector<std::vector<double> >& state_values)
+{
+  state_values.clear();
+  interpolation_joint_state_group_1_->setStateValues(angles1);
+  interpolation_joint_state_group_2_->setStateValues(angles2);
+  int maximum_moves = getJointDistanceIntegerMax(angles1, angles2, planning_parameters_.interpolation_distance_);
+  for (int i = 1; i < maximum_moves; i++)
+  {
+    interpolation_joint_state_group_1_->interpolate(
+        interpolation_joint_state_group_2_, (1.0 / (maximum_moves * 1.0)) * i, interpolation_joint_state_group_temp_);
+    state_values.resize(state_values.size() + 1);
+    interpolation_joint_state_group_temp_->getGroupStateValues(state_values.back());
+  }
+}
+
 void EnvironmentChain3D::attemptShortcut(const trajectory_msgs::JointTrajectory& traj_in,
                                          trajectory_msgs::JointTrajectory& traj_out)
 {
@@ -50,6 +50,7 @@ bool SBPLInterface::solve(const planning_scene::PlanningSceneConstPtr& planning_
 
   ros::WallTime wt = ros::WallTime::now();
   boost::shared_ptr<EnvironmentChain3D> env_chain(new EnvironmentChain3D(planning_scene));
+  env_chain->setBFSHeuristicCache(bfs_cache_);
   if (!env_chain->setupForMotionPlan(planning_scene, req, res, params))
   {
     // std::cerr << "Env chain setup failing" << std::endl;
@@ -78,10 +79,11 @@ bool SBPLInterface::solve(const planning_scene::PlanningSceneConstPtr& planning_
   std::cerr << "Expansions " << env_chain->getPlanningStatistics().total_expansions_ << " average time "
             << (env_chain->getPlanningStatistics().total_expansion_time_.toSec() /
                 (env_chain->getPlanningStatistics().total_expansions_ * 1.0))
-            << " hz "
-            << 1.0 / (env_chain->getPlanningStatistics().total_expansion_time_.toSec() /
-                      (env_chain->getPlanningStatistics().total_expansions_ * 1.0))
-            << std::endl;
+            << " hz " << env_chain->getPlanningStatistics().getExpansionsPerSecond() << std::endl;
+  ROS_DEBUG_STREAM("Interpolations cached " << env_chain->getPlanningStatistics().cached_interpolations_
+                                           << " not cached "
+                                           << env_chain->getPlanningStatistics().uncached_interpolations_
+                                           << " bfs reused " << env_chain->getPlanningStatistics().bfs_reused_);
   std::cerr << "Total coll checks " << env_chain->getPlanningStatistics().coll_checks_ << " hz "
             << 1.0 / (env_chain->getPlanningStatistics().total_coll_check_time_.toSec() /
                       (env_chain->getPlanningStatistics().coll_checks_ * 1.0))
@@ -68,7 +68,7 @@ bool isStateValid(const planning_scene::PlanningScene* planning_scene,
   state->setJointGroupPositions(group, ik_solution);
   state->update();
   return (!planning_scene || !planning_scene->isStateColliding(*state, group->getName())) &&
-         (!constraint_set || constraint_set->decide(*state).satisfied);
+         (!constraint_set || constraint_set->satisfies(*state));
 }
 }  // namespace
 
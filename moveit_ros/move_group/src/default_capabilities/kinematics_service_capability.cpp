@@ -62,7 +62,7 @@ bool isIKSolutionValid(const planning_scene::PlanningScene* planning_scene,
   state->setJointGroupPositions(jmg, ik_solution);
   state->update();
   return (!planning_scene || !planning_scene->isStateColliding(*state, jmg->getName())) &&
-         (!constraint_set || constraint_set->decide(*state).satisfied);
+         (!constraint_set || constraint_set->satisfies(*state));
 }
 }  // namespace
 
@@ -0,0 +1,223 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/dynamics_solver/dynamics_solver.h>
+#include <class_loader/class_loader.hpp>
+#include <boost/thread/mutex.hpp>
+#include <ros/ros.h>
+
+namespace default_planner_request_adapters
+{
+/** @brief This adapter evaluates the joint torques along time-parameterized solution paths and either slows the
+ * trajectory down until it respects the effort limits of the group, or rejects it. It must run after one of the
+ * time parameterization adapters. */
+class EnforceTorqueLimits : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  static const std::string RESCALE_PARAM_NAME;
+  static const std::string ATTEMPTS_PARAM_NAME;
+  static const std::string THREADS_PARAM_NAME;
+  static const std::string GRAVITY_PARAM_NAME;
+
+  EnforceTorqueLimits() : planning_request_adapter::PlanningRequestAdapter(), nh_("~")
+  {
+    if (!nh_.getParam(RESCALE_PARAM_NAME, rescale_))
+    {
+      rescale_ = true;
+      ROS_INFO_STREAM("Param '" << RESCALE_PARAM_NAME << "' was not set. Using default value: " << rescale_);
+    }
+    else
+      ROS_INFO_STREAM("Param '" << RESCALE_PARAM_NAME << "' was set to " << rescale_);
+
+    if (!nh_.getParam(ATTEMPTS_PARAM_NAME, rescale_attempts_))
+    {
+      rescale_attempts_ = 10;
+      ROS_INFO_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' was not set. Using default value: " << rescale_attempts_);
+    }
+    else
+    {
+      if (rescale_attempts_ < 1)
+      {
+        rescale_attempts_ = 1;
+        ROS_WARN_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' needs to be at least 1.");
+      }
+      ROS_INFO_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' was set to " << rescale_attempts_);
+    }
+
+    if (!nh_.getParam(THREADS_PARAM_NAME, num_threads_) || num_threads_ < 0)
+      num_threads_ = 1;
+
+    std::vector<double> gravity;
+    gravity_.z = -9.81;
+    if (nh_.getParam(GRAVITY_PARAM_NAME, gravity))
+    {
+      if (gravity.size() == 3)
+      {
+        gravity_.x = gravity[0];
+        gravity_.y = gravity[1];
+        gravity_.z = gravity[2];
+      }
+      else
+        ROS_WARN_STREAM("Param '" << GRAVITY_PARAM_NAME << "' needs to be a vector of 3 elements. Ignoring it.");
+    }
+  }
+
+  std::string getDescription() const override
+  {
+    return "Enforce Torque Limits";
+  }
+
+  bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
+                    std::vector<std::size_t>& added_path_index) const override
+  {
+    bool result = planner(planning_scene, req, res);
+    if (!result || !res.trajectory_ || res.trajectory_->empty())
+      return result;
+
+    ROS_DEBUG("Running '%s'", getDescription().c_str());
+    dynamics_solver::DynamicsSolverPtr solver = getSolver(planning_scene->getRobotModel(), req.group_name);
+    if (!solver)
+    {
+      ROS_DEBUG("Torque limits are not checked for group '%s'", req.group_name.c_str());
+      return result;
+    }
+
+    robot_trajectory::RobotTrajectory& trajectory = *res.trajectory_;
+    const std::vector<double>& max_torques = solver->getMaxTorques();
+    std::vector<std::vector<double> > torques;
+    for (int attempt = 0;; ++attempt)
+    {
+      if (!solver->getTrajectoryTorques(trajectory, 0.0, torques, num_threads_))
+      {
+        ROS_WARN("Unable to compute torques for the solution path. Not checking torque limits.");
+        return result;
+      }
+
+      // largest ratio of required torque to the torque limit over the whole trajectory
+      double max_ratio = 0.0;
+      for (const std::vector<double>& waypoint_torques : torques)
+        for (std::size_t j = 0; j < waypoint_torques.size(); ++j)
+          if (max_torques[j] > 0.0)
+            max_ratio = std::max(max_ratio, std::fabs(waypoint_torques[j]) / max_torques[j]);
+
+      if (max_ratio <= 1.0)
+      {
+        if (attempt > 0)
+          ROS_INFO("Solution path was slowed down to respect torque limits after %d attempts", attempt);
+        return result;
+      }
+
+      if (!rescale_ || attempt >= rescale_attempts_ || !staticallyFeasible(*solver, trajectory))
+        break;
+
+      // inertial and Coriolis torques scale with the inverse square of the time scaling;
+      // gravity torques do not, so this step can undershoot and is repeated as needed
+      scaleTrajectory(trajectory, std::sqrt(max_ratio));
+    }
+
+    ROS_ERROR("Solution path exceeds the torque limits of group '%s'", req.group_name.c_str());
+    res.error_code_.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
+    return false;
+  }
+
+private:
+  dynamics_solver::DynamicsSolverPtr getSolver(const robot_model::RobotModelConstPtr& robot_model,
+                                               const std::string& group_name) const
+  {
+    boost::mutex::scoped_lock slock(solvers_lock_);
+    dynamics_solver::DynamicsSolverPtr& solver = solvers_[group_name];
+    if (!solver || solver->getRobotModel() != robot_model)
+      solver.reset(new dynamics_solver::DynamicsSolver(robot_model, group_name, gravity_));
+    // an uninitialized solver (e.g. the group is not a chain) reports no group
+    return solver->getGroup() ? solver : dynamics_solver::DynamicsSolverPtr();
+  }
+
+  /** \brief Check whether the trajectory can hold its own weight at every waypoint; if not, slowing down cannot help */
+  bool staticallyFeasible(const dynamics_solver::DynamicsSolver& solver,
+                          const robot_trajectory::RobotTrajectory& trajectory) const
+  {
+    std::vector<double> payloads;
+    std::vector<unsigned int> joint_saturated;
+    if (!solver.getTrajectoryMaxPayload(trajectory, payloads, joint_saturated, num_threads_))
+      return false;
+    for (std::size_t i = 0; i < payloads.size(); ++i)
+      if (payloads[i] <= 0.0)
+      {
+        ROS_DEBUG("Joint %u is saturated by gravity at waypoint %zu", joint_saturated[i], i);
+        return false;
+      }
+    return true;
+  }
+
+  /** \brief Stretch the duration of the trajectory by \e factor, scaling velocities and accelerations accordingly */
+  static void scaleTrajectory(robot_trajectory::RobotTrajectory& trajectory, double factor)
+  {
+    if (!trajectory.getGroup())
+      return;
+    const std::vector<int>& indices = trajectory.getGroup()->getVariableIndexList();
+    const double factor_sq = factor * factor;
+    for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    {
+      trajectory.setWayPointDurationFromPrevious(i, trajectory.getWayPointDurationFromPrevious(i) * factor);
+      robot_state::RobotStatePtr& waypoint = trajectory.getWayPointPtr(i);
+      for (int index : indices)
+      {
+        if (waypoint->hasVelocities())
+          waypoint->setVariableVelocity(index, waypoint->getVariableVelocity(index) / factor);
+        if (waypoint->hasAccelerations())
+          waypoint->setVariableAcceleration(index, waypoint->getVariableAcceleration(index) / factor_sq);
+      }
+    }
+  }
+
+  ros::NodeHandle nh_;
+  bool rescale_;
+  int rescale_attempts_;
+  int num_threads_;
+  geometry_msgs::Vector3 gravity_;
+
+  mutable boost::mutex solvers_lock_;
+  mutable std::map<std::string, dynamics_solver::DynamicsSolverPtr> solvers_;
+};
+
+const std::string EnforceTorqueLimits::RESCALE_PARAM_NAME = "torque_limits_rescale";
+const std::string EnforceTorqueLimits::ATTEMPTS_PARAM_NAME = "torque_limits_rescale_attempts";
+const std::string EnforceTorqueLimits::THREADS_PARAM_NAME = "torque_limits_threads";
+const std::string EnforceTorqueLimits::GRAVITY_PARAM_NAME = "torque_limits_gravity";
+}  // namespace default_planner_request_adapters
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::EnforceTorqueLimits,
+                            planning_request_adapter::PlanningRequestAdapter);
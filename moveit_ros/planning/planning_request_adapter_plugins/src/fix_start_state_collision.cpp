@@ -37,7 +37,9 @@
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
+#include <moveit/utils/parallel_chunks.h>
 #include <class_loader/class_loader.hpp>
+#include <boost/thread.hpp>
 #include <ros/ros.h>
 
 namespace default_planner_request_adapters
@@ -48,6 +50,10 @@ public:
   static const std::string DT_PARAM_NAME;
   static const std::string JIGGLE_PARAM_NAME;
   static const std::string ATTEMPTS_PARAM_NAME;
+  static const std::string THREADS_PARAM_NAME;
+  static const std::string BATCH_PARAM_NAME;
+  static const std::string SEED_PARAM_NAME;
+  static const std::string CLOSEST_PARAM_NAME;
 
   FixStartStateCollision() : planning_request_adapter::PlanningRequestAdapter(), nh_("~")
   {
@@ -67,6 +73,10 @@ public:
     else
       ROS_INFO_STREAM("Param '" << JIGGLE_PARAM_NAME << "' was set to " << jiggle_fraction_);
 
+    // Every attempt samples one candidate that jiggles all joints of the group at once and checks it for collision,
+    // so there are at most max_sampling_attempts collision checks. Before candidates were sampled in parallel, each
+    // attempt moved one joint after the other and checked the state after every joint, i.e. the changes accumulated
+    // and an attempt took up to one check per joint.
     if (!nh_.getParam(ATTEMPTS_PARAM_NAME, sampling_attempts_))
     {
       sampling_attempts_ = 100;
@@ -81,6 +91,20 @@ public:
       }
       ROS_INFO_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' was set to " << sampling_attempts_);
     }
+
+    if (!nh_.getParam(THREADS_PARAM_NAME, sampling_threads_) || sampling_threads_ < 1)
+      sampling_threads_ = std::max(1u, boost::thread::hardware_concurrency());
+
+    // the batch size (not the thread count) decides which candidate is chosen, so results do not depend on the
+    // number of available cores
+    if (!nh_.getParam(BATCH_PARAM_NAME, batch_size_) || batch_size_ < 1)
+      batch_size_ = 8;
+
+    if (!nh_.getParam(SEED_PARAM_NAME, seed_))
+      seed_ = 0;
+
+    if (!nh_.getParam(CLOSEST_PARAM_NAME, prefer_closest_))
+      prefer_closest_ = false;
   }
 
   std::string getDescription() const override
@@ -116,32 +140,70 @@ public:
         ROS_INFO_STREAM("Start state appears to be in collision with respect to group " << creq.group_name);
 
       robot_state::RobotStatePtr prefix_state(new robot_state::RobotState(start_state));
-      random_numbers::RandomNumberGenerator& rng = prefix_state->getRandomNumberGenerator();
 
       const std::vector<const robot_model::JointModel*>& jmodels =
           planning_scene->getRobotModel()->hasJointModelGroup(req.group_name) ?
               planning_scene->getRobotModel()->getJointModelGroup(req.group_name)->getJointModels() :
               planning_scene->getRobotModel()->getJointModels();
 
+      // Candidates are sampled and checked in batches, in parallel. Candidate c is always generated from the seed
+      // (seed_ + c), so the chosen state is reproducible and independent of the number of threads.
       bool found = false;
-      for (int c = 0; !found && c < sampling_attempts_; ++c)
+      std::vector<robot_state::RobotState> candidates(batch_size_, *prefix_state);
+      std::vector<char> valid(batch_size_);
+      for (int batch_start = 0; !found && batch_start < sampling_attempts_; batch_start += batch_size_)
       {
-        for (std::size_t i = 0; !found && i < jmodels.size(); ++i)
+        const int batch = std::min(batch_size_, sampling_attempts_ - batch_start);
+        moveit::core::runChunked(batch, sampling_threads_, [&](std::size_t begin, std::size_t end) {
+          std::vector<double> sampled_variable_values;
+          for (std::size_t k = begin; k < end; ++k)
+          {
+            random_numbers::RandomNumberGenerator rng(static_cast<boost::uint32_t>(seed_ + batch_start + k));
+            robot_state::RobotState& candidate = candidates[k];
+            candidate = *prefix_state;
+            for (const robot_model::JointModel* jmodel : jmodels)
+            {
+              sampled_variable_values.resize(jmodel->getVariableCount());
+              jmodel->getVariableRandomPositionsNearBy(rng, &sampled_variable_values[0],
+                                                       prefix_state->getJointPositions(jmodel),
+                                                       jmodel->getMaximumExtent() * jiggle_fraction_);
+              candidate.setJointPositions(jmodel, sampled_variable_values);
+            }
+            candidate.update();
+            collision_detection::CollisionResult cres;
+            planning_scene->checkCollision(creq, cres, candidate);
+            valid[k] = !cres.collision;
+          }
+          return true;
+        });
+
+        // pick the first valid candidate of the batch, or the one closest to the original start state
+        int best = -1;
+        double best_distance = std::numeric_limits<double>::infinity();
+        for (int k = 0; k < batch; ++k)
         {
-          std::vector<double> sampled_variable_values(jmodels[i]->getVariableCount());
-          const double* original_values = prefix_state->getJointPositions(jmodels[i]);
-          jmodels[i]->getVariableRandomPositionsNearBy(rng, &sampled_variable_values[0], original_values,
-                                                       jmodels[i]->getMaximumExtent() * jiggle_fraction_);
-          start_state.setJointPositions(jmodels[i], sampled_variable_values);
-          collision_detection::CollisionResult cres;
-          planning_scene->checkCollision(creq, cres, start_state);
-          if (!cres.collision)
+          if (!valid[k])
+            continue;
+          if (!prefer_closest_)
+          {
+            best = k;
+            break;
+          }
+          const double distance = prefix_state->distance(candidates[k]);
+          if (distance < best_distance)
           {
-            found = true;
-            ROS_INFO("Found a valid state near the start state at distance %lf after %d attempts",
-                     prefix_state->distance(start_state), c);
+            best_distance = distance;
+            best = k;
           }
         }
+
+        if (best >= 0)
+        {
+          found = true;
+          start_state = candidates[best];
+          ROS_INFO("Found a valid state near the start state at distance %lf after %d attempts",
+                   prefix_state->distance(start_state), batch_start + best);
+        }
       }
 
       if (found)
@@ -186,11 +248,19 @@ private:
   double max_dt_offset_;
   double jiggle_fraction_;
   int sampling_attempts_;
+  int sampling_threads_;
+  int batch_size_;
+  int seed_;
+  bool prefer_closest_;
 };
 
 const std::string FixStartStateCollision::DT_PARAM_NAME = "start_state_max_dt";
 const std::string FixStartStateCollision::JIGGLE_PARAM_NAME = "jiggle_fraction";
 const std::string FixStartStateCollision::ATTEMPTS_PARAM_NAME = "max_sampling_attempts";
+const std::string FixStartStateCollision::THREADS_PARAM_NAME = "sampling_threads";
+const std::string FixStartStateCollision::BATCH_PARAM_NAME = "sampling_batch_size";
+const std::string FixStartStateCollision::SEED_PARAM_NAME = "sampling_seed";
+const std::string FixStartStateCollision::CLOSEST_PARAM_NAME = "prefer_closest_valid_state";
 }  // namespace default_planner_request_adapters
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::FixStartStateCollision,
@@ -0,0 +1,155 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/dynamics_solver/dynamics_solver.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <pluginlib/class_loader.hpp>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+const std::string GROUP = "right_arm";
+const std::size_t WAYPOINTS = 10;
+const double DURATION = 0.1;
+}  // namespace
+
+class EnforceTorqueLimitsTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("pr2");
+    planning_scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    loader_.reset(new pluginlib::ClassLoader<planning_request_adapter::PlanningRequestAdapter>(
+        "moveit_core", "planning_request_adapter::PlanningRequestAdapter"));
+
+    // without gravity the torques scale exactly with the inverse square of the time scaling
+    ros::NodeHandle nh("~");
+    nh.setParam("torque_limits_gravity", std::vector<double>(3, 0.0));
+    solver_.reset(new dynamics_solver::DynamicsSolver(robot_model_, GROUP, geometry_msgs::Vector3()));
+    ASSERT_TRUE(solver_->getGroup());
+    req_.group_name = GROUP;
+  }
+
+  planning_request_adapter::PlanningRequestAdapterPtr loadAdapter(bool rescale)
+  {
+    ros::NodeHandle("~").setParam("torque_limits_rescale", rescale);
+    return loader_->createUniqueInstance("default_planner_request_adapters/EnforceTorqueLimits");
+  }
+
+  /** \brief Planner stub returning a trajectory that accelerates all joints of the group at \e acceleration */
+  planning_request_adapter::PlanningRequestAdapter::PlannerFn planner(double acceleration)
+  {
+    return [this, acceleration](const planning_scene::PlanningSceneConstPtr& /*scene*/,
+                                const planning_interface::MotionPlanRequest& req,
+                                planning_interface::MotionPlanResponse& res) {
+      robot_state::RobotState state(robot_model_);
+      state.setToDefaultValues();
+      const std::vector<double> accelerations(solver_->getGroup()->getVariableCount(), acceleration);
+      state.setJointGroupVelocities(solver_->getGroup(), std::vector<double>(accelerations.size(), 0.0));
+      state.setJointGroupAccelerations(solver_->getGroup(), accelerations);
+      res.trajectory_.reset(new robot_trajectory::RobotTrajectory(robot_model_, req.group_name));
+      for (std::size_t i = 0; i < WAYPOINTS; ++i)
+        res.trajectory_->addSuffixWayPoint(state, DURATION);
+      res.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+      return true;
+    };
+  }
+
+  /** \brief Largest ratio of the required torque to the torque limit along \e trajectory */
+  double maxTorqueRatio(const robot_trajectory::RobotTrajectory& trajectory)
+  {
+    std::vector<std::vector<double> > torques;
+    EXPECT_TRUE(solver_->getTrajectoryTorques(trajectory, 0.0, torques));
+    const std::vector<double>& max_torques = solver_->getMaxTorques();
+    double max_ratio = 0.0;
+    for (const std::vector<double>& waypoint_torques : torques)
+      for (std::size_t j = 0; j < waypoint_torques.size(); ++j)
+        if (max_torques[j] > 0.0)
+          max_ratio = std::max(max_ratio, std::fabs(waypoint_torques[j]) / max_torques[j]);
+    return max_ratio;
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+  planning_scene::PlanningScenePtr planning_scene_;
+  dynamics_solver::DynamicsSolverPtr solver_;
+  std::unique_ptr<pluginlib::ClassLoader<planning_request_adapter::PlanningRequestAdapter> > loader_;
+  planning_interface::MotionPlanRequest req_;
+  planning_interface::MotionPlanResponse res_;
+  std::vector<std::size_t> added_path_index_;
+};
+
+TEST_F(EnforceTorqueLimitsTest, KeepsFeasibleTrajectory)
+{
+  planning_request_adapter::PlanningRequestAdapterPtr adapter = loadAdapter(true);
+  ASSERT_TRUE(adapter);
+  ASSERT_TRUE(adapter->adaptAndPlan(planner(0.01), planning_scene_, req_, res_, added_path_index_));
+  ASSERT_TRUE(res_.trajectory_);
+  EXPECT_LE(maxTorqueRatio(*res_.trajectory_), 1.0);
+  for (std::size_t i = 0; i < res_.trajectory_->getWayPointCount(); ++i)
+    EXPECT_DOUBLE_EQ(res_.trajectory_->getWayPointDurationFromPrevious(i), DURATION);
+}
+
+TEST_F(EnforceTorqueLimitsTest, RescalesInfeasibleTrajectory)
+{
+  planning_request_adapter::PlanningRequestAdapterPtr adapter = loadAdapter(true);
+  ASSERT_TRUE(adapter);
+  planning_interface::MotionPlanResponse unscaled;
+  ASSERT_TRUE(planner(100.0)(planning_scene_, req_, unscaled));
+  ASSERT_GT(maxTorqueRatio(*unscaled.trajectory_), 1.0);
+
+  ASSERT_TRUE(adapter->adaptAndPlan(planner(100.0), planning_scene_, req_, res_, added_path_index_));
+  ASSERT_TRUE(res_.trajectory_);
+  EXPECT_LE(maxTorqueRatio(*res_.trajectory_), 1.0);
+  EXPECT_GT(res_.trajectory_->getWayPointDurationFromStart(WAYPOINTS - 1),
+            unscaled.trajectory_->getWayPointDurationFromStart(WAYPOINTS - 1));
+}
+
+TEST_F(EnforceTorqueLimitsTest, RejectsInfeasibleTrajectory)
+{
+  planning_request_adapter::PlanningRequestAdapterPtr adapter = loadAdapter(false);
+  ASSERT_TRUE(adapter);
+  EXPECT_FALSE(adapter->adaptAndPlan(planner(100.0), planning_scene_, req_, res_, added_path_index_));
+  EXPECT_EQ(res_.error_code_.val, moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_enforce_torque_limits");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/utils/robot_model_test_utils.h>
+#include <geometric_shapes/shapes.h>
+#include <pluginlib/class_loader.hpp>
+#include <ros/ros.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+const std::string GROUP = "right_arm";
+}  // namespace
+
+class FixStartStateCollisionTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    robot_model_ = moveit::core::loadTestingRobotModel("pr2");
+    planning_scene_.reset(new planning_scene::PlanningScene(robot_model_));
+    loader_.reset(new pluginlib::ClassLoader<planning_request_adapter::PlanningRequestAdapter>(
+        "moveit_core", "planning_request_adapter::PlanningRequestAdapter"));
+
+    // a sphere around the gripper puts the default state in collision
+    robot_state::RobotState& state = planning_scene_->getCurrentStateNonConst();
+    state.setToDefaultValues();
+    state.update();
+    planning_scene_->getWorldNonConst()->addToObject("sphere", shapes::ShapeConstPtr(new shapes::Sphere(0.05)),
+                                                     state.getGlobalLinkTransform("r_gripper_palm_link"));
+    ASSERT_TRUE(planning_scene_->isStateColliding(state, GROUP));
+
+    robot_state::robotStateToRobotStateMsg(state, req_.start_state);
+    req_.group_name = GROUP;
+
+    ros::NodeHandle nh("~");
+    nh.setParam("jiggle_fraction", 0.2);
+    nh.setParam("max_sampling_attempts", 100);
+    nh.setParam("sampling_seed", 42);
+  }
+
+  /** \brief Run the adapter with the given parameters and return the start state it passes to the planner */
+  sensor_msgs::JointState chosenStartState(int threads, bool prefer_closest)
+  {
+    ros::NodeHandle nh("~");
+    nh.setParam("sampling_threads", threads);
+    nh.setParam("prefer_closest_valid_state", prefer_closest);
+    planning_request_adapter::PlanningRequestAdapterPtr adapter =
+        loader_->createUniqueInstance("default_planner_request_adapters/FixStartStateCollision");
+    EXPECT_TRUE(adapter);
+    if (!adapter)
+      return sensor_msgs::JointState();
+
+    sensor_msgs::JointState start_state;
+    auto planner = [&start_state](const planning_scene::PlanningSceneConstPtr& /*scene*/,
+                                  const planning_interface::MotionPlanRequest& req,
+                                  planning_interface::MotionPlanResponse& /*res*/) {
+      start_state = req.start_state.joint_state;
+      return false;
+    };
+    planning_interface::MotionPlanResponse res;
+    std::vector<std::size_t> added_path_index;
+    adapter->adaptAndPlan(planner, planning_scene_, req_, res, added_path_index);
+
+    // the adapter has to have found a valid state
+    robot_state::RobotState state(robot_model_);
+    state.setVariableValues(start_state);
+    state.update();
+    EXPECT_NE(start_state.position, req_.start_state.joint_state.position);
+    EXPECT_FALSE(planning_scene_->isStateColliding(state, GROUP));
+    return start_state;
+  }
+
+  robot_model::RobotModelPtr robot_model_;
+  planning_scene::PlanningScenePtr planning_scene_;
+  std::unique_ptr<pluginlib::ClassLoader<planning_request_adapter::PlanningRequestAdapter> > loader_;
+  planning_interface::MotionPlanRequest req_;
+};
+
+TEST_F(FixStartStateCollisionTest, FirstValidStateIsIndependentOfThreads)
+{
+  sensor_msgs::JointState serial = chosenStartState(1, false);
+  sensor_msgs::JointState parallel = chosenStartState(4, false);
+  EXPECT_EQ(serial.name, parallel.name);
+  EXPECT_EQ(serial.position, parallel.position);
+}
+
+TEST_F(FixStartStateCollisionTest, ClosestValidStateIsIndependentOfThreads)
+{
+  sensor_msgs::JointState serial = chosenStartState(1, true);
+  sensor_msgs::JointState parallel = chosenStartState(4, true);
+  EXPECT_EQ(serial.name, parallel.name);
+  EXPECT_EQ(serial.position, parallel.position);
+
+  // the closest valid state of a batch is never farther from the start state than the first one
+  robot_state::RobotState original(robot_model_), first(robot_model_), closest(robot_model_);
+  original.setVariableValues(req_.start_state.joint_state);
+  first.setVariableValues(chosenStartState(4, false));
+  closest.setVariableValues(parallel);
+  EXPECT_LE(original.distance(closest), original.distance(first));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_fix_start_state_collision");
+  return RUN_ALL_TESTS();
+}
@@ -54,12 +54,19 @@ public:
   struct Options
   {
     Options(const std::string& robot_description = "robot_description")
-      : robot_description_(robot_description), load_kinematics_solvers_(true)
+      : robot_description_(robot_description)
+      , load_kinematics_solvers_(true)
+      , kinematics_solver_threads_(0)
+      , mesh_loading_threads_(0)
     {
     }
 
     Options(const std::string& urdf_string, const std::string& srdf_string)
-      : urdf_string_(urdf_string), srdf_string_(srdf_string), load_kinematics_solvers_(true)
+      : urdf_string_(urdf_string)
+      , srdf_string_(srdf_string)
+      , load_kinematics_solvers_(true)
+      , kinematics_solver_threads_(0)
+      , mesh_loading_threads_(0)
     {
     }
 
@@ -75,6 +82,22 @@ public:
     /** @brief Flag indicating whether the kinematics solvers should be loaded as well, using specified ROS parameters
      */
     bool load_kinematics_solvers_;
+
+    /** @brief Number of threads that initialize the kinematics solvers of the different groups. 1 initializes them
+        one after the other, larger values are capped at the number of CPU cores. If 0, the ROS parameter
+        "robot_model_kinematics_solver_threads" (searched from the private namespace) is used; if that is not set
+        either, the solvers are initialized serially */
+    unsigned int kinematics_solver_threads_;
+
+    /** @brief Directory in which decoded meshes are cached between runs. If empty, the ROS parameter
+        "robot_model_mesh_cache_directory" (searched from the private namespace) is used; if that is not set either,
+        meshes are not cached */
+    std::string mesh_cache_directory_;
+
+    /** @brief Number of threads that decode the meshes of the robot. The model does not depend on this number. If 0,
+        the ROS parameter "robot_model_mesh_loading_threads" (searched from the private namespace) is used; if that is
+        not set either or is 0, one thread per CPU core is used */
+    unsigned int mesh_loading_threads_;
   };
 
   /** @brief Default constructor */
@@ -132,6 +155,7 @@ private:
   robot_model::RobotModelPtr model_;
   rdf_loader::RDFLoaderPtr rdf_loader_;
   kinematics_plugin_loader::KinematicsPluginLoaderPtr kinematics_loader_;
+  unsigned int kinematics_solver_threads_;
 };
 }
 #endif
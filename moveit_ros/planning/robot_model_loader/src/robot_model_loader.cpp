@@ -36,7 +36,9 @@
 
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/profiler/profiler.h>
+#include <moveit/utils/parallel_chunks.h>
 #include <ros/ros.h>
+#include <boost/thread/thread.hpp>
 #include <typeinfo>
 
 namespace robot_model_loader
@@ -89,15 +91,49 @@ void RobotModelLoader::configure(const Options& opt)
   moveit::tools::Profiler::ScopedBlock prof_block("RobotModelLoader::configure");
 
   ros::WallTime start = ros::WallTime::now();
+  kinematics_solver_threads_ = opt.kinematics_solver_threads_;
+  if (kinematics_solver_threads_ == 0)
+  {
+    ros::NodeHandle nh("~");
+    std::string param_name;
+    int threads = 1;
+    if (nh.searchParam("robot_model_kinematics_solver_threads", param_name))
+      nh.getParam(param_name, threads);
+    kinematics_solver_threads_ = std::max(1, threads);
+  }
+
   if (!opt.urdf_string_.empty() && !opt.srdf_string_.empty())
     rdf_loader_.reset(new rdf_loader::RDFLoader(opt.urdf_string_, opt.srdf_string_));
   else
     rdf_loader_.reset(new rdf_loader::RDFLoader(opt.robot_description_));
   if (rdf_loader_->getURDF())
   {
+    std::string mesh_cache_directory = opt.mesh_cache_directory_;
+    if (mesh_cache_directory.empty())
+    {
+      ros::NodeHandle nh("~");
+      std::string param_name;
+      if (nh.searchParam("robot_model_mesh_cache_directory", param_name))
+        nh.getParam(param_name, mesh_cache_directory);
+    }
+    robot_model::MeshCacheConstPtr mesh_cache;
+    if (!mesh_cache_directory.empty())
+      mesh_cache.reset(new robot_model::MeshCache(mesh_cache_directory));
+
+    unsigned int mesh_loading_threads = opt.mesh_loading_threads_;
+    if (mesh_loading_threads == 0)
+    {
+      ros::NodeHandle nh("~");
+      std::string param_name;
+      int threads = 0;
+      if (nh.searchParam("robot_model_mesh_loading_threads", param_name))
+        nh.getParam(param_name, threads);
+      mesh_loading_threads = std::max(0, threads);
+    }
+
     const srdf::ModelSharedPtr& srdf =
         rdf_loader_->getSRDF() ? rdf_loader_->getSRDF() : srdf::ModelSharedPtr(new srdf::Model());
-    model_.reset(new robot_model::RobotModel(rdf_loader_->getURDF(), srdf));
+    model_.reset(new robot_model::RobotModel(rdf_loader_->getURDF(), srdf, mesh_cache, mesh_loading_threads));
   }
 
   if (model_ && !rdf_loader_->getRobotDescription().empty())
@@ -184,16 +220,47 @@ void RobotModelLoader::loadKinematicsSolvers(const kinematics_plugin_loader::Kin
     if (groups.empty() && !model_->getJointModelGroups().empty())
       ROS_WARN("No kinematics plugins defined. Fill and load kinematics.yaml!");
 
-    std::map<std::string, robot_model::SolverAllocatorFn> imap;
+    // Check if a group in kinematics.yaml exists in the srdf
+    std::vector<const robot_model::JointModelGroup*> jmgs;
     for (const std::string& group : groups)
-    {
-      // Check if a group in kinematics.yaml exists in the srdf
-      if (!model_->hasJointModelGroup(group))
-        continue;
+      if (model_->hasJointModelGroup(group))
+        jmgs.push_back(model_->getJointModelGroup(group));
 
-      const robot_model::JointModelGroup* jmg = model_->getJointModelGroup(group);
+    // Solver initialization (parsing the robot model, building chains, loading caches) is independent for each group,
+    // so the solvers can be allocated in parallel if configured. The allocator caches them, so
+    // setKinematicsAllocators() below reuses these instances instead of initializing new ones.
+    std::vector<kinematics::KinematicsBasePtr> solvers(jmgs.size());
+    std::vector<double> durations(jmgs.size(), 0.0);
+    const unsigned int num_threads =
+        std::min(kinematics_solver_threads_, std::max(1u, boost::thread::hardware_concurrency()));
+    moveit::core::runChunked(jmgs.size(), num_threads, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i)
+      {
+        ros::WallTime start = ros::WallTime::now();
+        try
+        {
+          solvers[i] = kinematics_allocator(jmgs[i]);
+        }
+        catch (std::exception& ex)
+        {
+          ROS_ERROR("Exception while allocating kinematics solver for joint group %s: %s", jmgs[i]->getName().c_str(),
+                    ex.what());
+        }
+        durations[i] = (ros::WallTime::now() - start).toSec();
+      }
+      return true;
+    });
+
+    std::map<std::string, robot_model::SolverAllocatorFn> imap;
+    for (std::size_t i = 0; i < jmgs.size(); ++i)
+    {
+      const robot_model::JointModelGroup* jmg = jmgs[i];
+      const std::string& group = jmg->getName();
+      ROS_DEBUG_STREAM_NAMED("robot_model_loader", "Allocated kinematics solver for group '"
+                                                       << group << "' in " << durations[i] << " seconds");
 
-      kinematics::KinematicsBasePtr solver = kinematics_allocator(jmg);
+      kinematics::KinematicsBasePtr solver;
+      solver.swap(solvers[i]);
       if (solver)
       {
         std::string error_msg;
@@ -0,0 +1,208 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MOVEIT_WAREHOUSE_FILE_DATABASE_CONNECTION_
+#define MOVEIT_MOVEIT_WAREHOUSE_FILE_DATABASE_CONNECTION_
+
+#include <warehouse_ros/database_connection.h>
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace moveit_warehouse
+{
+/** \brief A single value stored in the metadata of a message */
+struct FileFieldValue
+{
+  enum Type
+  {
+    STRING,
+    DOUBLE,
+    INT,
+    BOOL
+  };
+
+  Type type_ = STRING;
+  std::string string_;
+  double double_ = 0.0;
+  int int_ = 0;
+  bool bool_ = false;
+
+  /** \brief Numeric view of the value, used for the ordering comparisons of queries */
+  double asDouble() const;
+
+  /** \brief Compare two values; strings are ordered lexicographically and are considered larger than any number */
+  int compare(const FileFieldValue& other) const;
+};
+
+/** \brief Metadata of a message stored by FileDatabaseConnection */
+class FileMetadata : public warehouse_ros::Metadata
+{
+public:
+  typedef boost::shared_ptr<FileMetadata> Ptr;
+  typedef boost::shared_ptr<const FileMetadata> ConstPtr;
+
+  std::string lookupString(const std::string& name) const override;
+  double lookupDouble(const std::string& name) const override;
+  int lookupInt(const std::string& name) const override;
+  bool lookupBool(const std::string& name) const override;
+  bool lookupField(const std::string& name) const override;
+  std::set<std::string> lookupFieldNames() const override;
+
+  const std::map<std::string, FileFieldValue>& getFields() const
+  {
+    return fields_;
+  }
+
+  void setField(const std::string& name, const FileFieldValue& value)
+  {
+    fields_[name] = value;
+  }
+
+protected:
+  void appendString(const std::string& name, const std::string& val) override;
+  void appendDouble(const std::string& name, const double val) override;
+  void appendInt(const std::string& name, const int val) override;
+  void appendBool(const std::string& name, const bool val) override;
+
+private:
+  const FileFieldValue* find(const std::string& name) const;
+
+  std::map<std::string, FileFieldValue> fields_;
+};
+
+/** \brief Query on the metadata of messages stored by FileDatabaseConnection. All appended conditions must hold. */
+class FileQuery : public warehouse_ros::Query
+{
+public:
+  typedef boost::shared_ptr<FileQuery> Ptr;
+  typedef boost::shared_ptr<const FileQuery> ConstPtr;
+
+  enum Operator
+  {
+    EQ,
+    LT,
+    LTE,
+    GT,
+    GTE
+  };
+
+  struct Condition
+  {
+    std::string field_;
+    Operator op_;
+    FileFieldValue value_;
+  };
+
+  void appendLT(const std::string& name, const double val) override;
+  void appendLTE(const std::string& name, const double val) override;
+  void appendGT(const std::string& name, const double val) override;
+  void appendGTE(const std::string& name, const double val) override;
+  void appendLT(const std::string& name, const int val) override;
+  void appendLTE(const std::string& name, const int val) override;
+  void appendGT(const std::string& name, const int val) override;
+  void appendGTE(const std::string& name, const int val) override;
+  void appendRange(const std::string& name, const double lower, const double upper) override;
+  void appendRange(const std::string& name, const int lower, const int upper) override;
+  void appendRangeInclusive(const std::string& name, const double lower, const double upper) override;
+  void appendRangeInclusive(const std::string& name, const int lower, const int upper) override;
+
+  /** \brief Check if \e metadata satisfies all conditions of this query */
+  bool matches(const FileMetadata& metadata) const;
+
+  const std::vector<Condition>& getConditions() const
+  {
+    return conditions_;
+  }
+
+protected:
+  void appendString(const std::string& name, const std::string& val) override;
+  void appendDouble(const std::string& name, const double val) override;
+  void appendInt(const std::string& name, const int val) override;
+  void appendBool(const std::string& name, const bool val) override;
+
+private:
+  void addCondition(const std::string& name, Operator op, const FileFieldValue& value);
+
+  std::vector<Condition> conditions_;
+};
+
+class FileDatabase;
+
+/** \brief A warehouse_ros database backend that keeps all messages in memory and persists them in a single local
+ * file, so no external database server is needed.
+ *
+ * The file is an append-only journal of inserts, removals and metadata changes; it is replayed on connect() and
+ * compacted when it contains mostly stale entries. Lookups by equality on string metadata fields (the scene, query,
+ * constraints and state names used by the MoveIt! storages) are served from an index instead of scanning the
+ * collection. The file can only be used by one process at a time: connect() takes an advisory lock on a "<file>.lock"
+ * file next to it and fails while another process holds that lock. All connections of one process to the same file
+ * share the same in-memory database.
+ *
+ * The database file is given as the host in setParams(); the port is ignored. If the host is "localhost" or empty,
+ * $ROS_HOME/moveit_warehouse.db is used. Select this backend by setting the warehouse_plugin parameter to
+ * moveit_warehouse::FileDatabaseConnection. */
+class FileDatabaseConnection : public warehouse_ros::DatabaseConnection
+{
+public:
+  FileDatabaseConnection();
+  ~FileDatabaseConnection() override;
+
+  bool setParams(const std::string& host, unsigned port, float timeout) override;
+  bool setTimeout(float timeout) override;
+  bool connect() override;
+  bool isConnected() override;
+  void dropDatabase(const std::string& db_name) override;
+  std::string messageType(const std::string& db_name, const std::string& collection_name) override;
+
+  /** \brief Get the path of the database file */
+  const std::string& getPath() const
+  {
+    return path_;
+  }
+
+protected:
+  warehouse_ros::MessageCollectionHelper::Ptr openCollectionHelper(const std::string& db_name,
+                                                                   const std::string& collection_name) override;
+
+private:
+  std::string path_;
+  std::shared_ptr<FileDatabase> database_;
+};
+}
+
+#endif
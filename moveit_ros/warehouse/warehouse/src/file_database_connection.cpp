@@ -0,0 +1,1144 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/warehouse/file_database_connection.h>
+#include <warehouse_ros/exceptions.h>
+#include <boost/filesystem.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <pluginlib/class_list_macros.hpp>
+#include <ros/console.h>
+#include <ros/time.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace moveit_warehouse
+{
+namespace
+{
+const char LOGNAME[] = "file_database";
+const char FILE_MAGIC[8] = { 'M', 'V', 'T', 'W', 'H', 'D', 'B', '1' };
+
+enum JournalOperation
+{
+  OP_COLLECTION = 1,
+  OP_INSERT = 2,
+  OP_REMOVE = 3,
+  OP_MODIFY = 4,
+  OP_DROP = 5
+};
+
+template <typename T>
+void writePod(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readPod(std::istream& in, T& value)
+{
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+void writeString(std::ostream& out, const std::string& value)
+{
+  writePod<uint64_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+bool readString(std::istream& in, std::string& value)
+{
+  uint64_t size;
+  if (!readPod(in, size))
+    return false;
+  value.resize(size);
+  return size == 0 || static_cast<bool>(in.read(&value[0], size));
+}
+
+void writeMetadata(std::ostream& out, const FileMetadata& metadata)
+{
+  writePod<uint32_t>(out, metadata.getFields().size());
+  for (const std::pair<const std::string, FileFieldValue>& field : metadata.getFields())
+  {
+    writeString(out, field.first);
+    writePod<uint8_t>(out, field.second.type_);
+    switch (field.second.type_)
+    {
+      case FileFieldValue::STRING:
+        writeString(out, field.second.string_);
+        break;
+      case FileFieldValue::DOUBLE:
+        writePod(out, field.second.double_);
+        break;
+      case FileFieldValue::INT:
+        writePod<int32_t>(out, field.second.int_);
+        break;
+      case FileFieldValue::BOOL:
+        writePod<uint8_t>(out, field.second.bool_);
+        break;
+    }
+  }
+}
+
+bool readMetadata(std::istream& in, FileMetadata& metadata)
+{
+  uint32_t count;
+  if (!readPod(in, count))
+    return false;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    std::string name;
+    uint8_t type;
+    if (!readString(in, name) || !readPod(in, type))
+      return false;
+    FileFieldValue value;
+    value.type_ = static_cast<FileFieldValue::Type>(type);
+    bool ok = false;
+    switch (value.type_)
+    {
+      case FileFieldValue::STRING:
+        ok = readString(in, value.string_);
+        break;
+      case FileFieldValue::DOUBLE:
+        ok = readPod(in, value.double_);
+        break;
+      case FileFieldValue::INT:
+      {
+        int32_t v;
+        ok = readPod(in, v);
+        value.int_ = v;
+        break;
+      }
+      case FileFieldValue::BOOL:
+      {
+        uint8_t v;
+        ok = readPod(in, v);
+        value.bool_ = v != 0;
+        break;
+      }
+    }
+    if (!ok)
+      return false;
+    metadata.setField(name, value);
+  }
+  return true;
+}
+
+/** \brief Key of the index entry for a string field with a given value */
+std::string indexKey(const std::string& field, const std::string& value)
+{
+  std::string key;
+  key.reserve(field.size() + value.size() + 1);
+  key.append(field).push_back('\0');
+  key.append(value);
+  return key;
+}
+
+std::string defaultDatabasePath()
+{
+  const char* ros_home = std::getenv("ROS_HOME");
+  if (ros_home)
+    return (boost::filesystem::path(ros_home) / "moveit_warehouse.db").string();
+  const char* home = std::getenv("HOME");
+  return (boost::filesystem::path(home ? home : ".") / ".ros" / "moveit_warehouse.db").string();
+}
+}  // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Values, metadata and queries
+
+double FileFieldValue::asDouble() const
+{
+  switch (type_)
+  {
+    case DOUBLE:
+      return double_;
+    case INT:
+      return int_;
+    case BOOL:
+      return bool_ ? 1.0 : 0.0;
+    default:
+      return 0.0;
+  }
+}
+
+int FileFieldValue::compare(const FileFieldValue& other) const
+{
+  if (type_ == STRING || other.type_ == STRING)
+  {
+    if (type_ != other.type_)
+      return type_ == STRING ? 1 : -1;
+    return string_.compare(other.string_);
+  }
+  const double a = asDouble();
+  const double b = other.asDouble();
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+const FileFieldValue* FileMetadata::find(const std::string& name) const
+{
+  std::map<std::string, FileFieldValue>::const_iterator it = fields_.find(name);
+  return it == fields_.end() ? nullptr : &it->second;
+}
+
+std::string FileMetadata::lookupString(const std::string& name) const
+{
+  const FileFieldValue* value = find(name);
+  if (!value || value->type_ != FileFieldValue::STRING)
+    throw warehouse_ros::WarehouseRosException("Metadata field '" + name + "' is not a string");
+  return value->string_;
+}
+
+double FileMetadata::lookupDouble(const std::string& name) const
+{
+  const FileFieldValue* value = find(name);
+  if (!value || value->type_ == FileFieldValue::STRING)
+    throw warehouse_ros::WarehouseRosException("Metadata field '" + name + "' is not a number");
+  return value->asDouble();
+}
+
+int FileMetadata::lookupInt(const std::string& name) const
+{
+  const FileFieldValue* value = find(name);
+  if (!value || value->type_ == FileFieldValue::STRING)
+    throw warehouse_ros::WarehouseRosException("Metadata field '" + name + "' is not a number");
+  return value->type_ == FileFieldValue::INT ? value->int_ : static_cast<int>(value->asDouble());
+}
+
+bool FileMetadata::lookupBool(const std::string& name) const
+{
+  const FileFieldValue* value = find(name);
+  if (!value || value->type_ == FileFieldValue::STRING)
+    throw warehouse_ros::WarehouseRosException("Metadata field '" + name + "' is not a boolean");
+  return value->asDouble() != 0.0;
+}
+
+bool FileMetadata::lookupField(const std::string& name) const
+{
+  return fields_.find(name) != fields_.end();
+}
+
+std::set<std::string> FileMetadata::lookupFieldNames() const
+{
+  std::set<std::string> names;
+  for (const std::pair<const std::string, FileFieldValue>& field : fields_)
+    names.insert(field.first);
+  return names;
+}
+
+void FileMetadata::appendString(const std::string& name, const std::string& val)
+{
+  FileFieldValue& value = fields_[name];
+  value.type_ = FileFieldValue::STRING;
+  value.string_ = val;
+}
+
+void FileMetadata::appendDouble(const std::string& name, const double val)
+{
+  FileFieldValue& value = fields_[name];
+  value.type_ = FileFieldValue::DOUBLE;
+  value.double_ = val;
+}
+
+void FileMetadata::appendInt(const std::string& name, const int val)
+{
+  FileFieldValue& value = fields_[name];
+  value.type_ = FileFieldValue::INT;
+  value.int_ = val;
+}
+
+void FileMetadata::appendBool(const std::string& name, const bool val)
+{
+  FileFieldValue& value = fields_[name];
+  value.type_ = FileFieldValue::BOOL;
+  value.bool_ = val;
+}
+
+void FileQuery::addCondition(const std::string& name, Operator op, const FileFieldValue& value)
+{
+  Condition condition;
+  condition.field_ = name;
+  condition.op_ = op;
+  condition.value_ = value;
+  conditions_.push_back(condition);
+}
+
+void FileQuery::appendString(const std::string& name, const std::string& val)
+{
+  FileFieldValue value;
+  value.type_ = FileFieldValue::STRING;
+  value.string_ = val;
+  addCondition(name, EQ, value);
+}
+
+void FileQuery::appendDouble(const std::string& name, const double val)
+{
+  FileFieldValue value;
+  value.type_ = FileFieldValue::DOUBLE;
+  value.double_ = val;
+  addCondition(name, EQ, value);
+}
+
+void FileQuery::appendInt(const std::string& name, const int val)
+{
+  FileFieldValue value;
+  value.type_ = FileFieldValue::INT;
+  value.int_ = val;
+  addCondition(name, EQ, value);
+}
+
+void FileQuery::appendBool(const std::string& name, const bool val)
+{
+  FileFieldValue value;
+  value.type_ = FileFieldValue::BOOL;
+  value.bool_ = val;
+  addCondition(name, EQ, value);
+}
+
+#define FILE_QUERY_APPEND_COMPARISON(METHOD, OP)                                                                     \
+  void FileQuery::METHOD(const std::string& name, const double val)                                                  \
+  {                                                                                                                  \
+    FileFieldValue value;                                                                                            \
+    value.type_ = FileFieldValue::DOUBLE;                                                                            \
+    value.double_ = val;                                                                                             \
+    addCondition(name, OP, value);                                                                                   \
+  }                                                                                                                  \
+  void FileQuery::METHOD(const std::string& name, const int val)                                                     \
+  {                                                                                                                  \
+    FileFieldValue value;                                                                                            \
+    value.type_ = FileFieldValue::INT;                                                                               \
+    value.int_ = val;                                                                                                \
+    addCondition(name, OP, value);                                                                                   \
+  }
+
+FILE_QUERY_APPEND_COMPARISON(appendLT, LT)
+FILE_QUERY_APPEND_COMPARISON(appendLTE, LTE)
+FILE_QUERY_APPEND_COMPARISON(appendGT, GT)
+FILE_QUERY_APPEND_COMPARISON(appendGTE, GTE)
+#undef FILE_QUERY_APPEND_COMPARISON
+
+void FileQuery::appendRange(const std::string& name, const double lower, const double upper)
+{
+  appendGT(name, lower);
+  appendLT(name, upper);
+}
+
+void FileQuery::appendRange(const std::string& name, const int lower, const int upper)
+{
+  appendGT(name, lower);
+  appendLT(name, upper);
+}
+
+void FileQuery::appendRangeInclusive(const std::string& name, const double lower, const double upper)
+{
+  appendGTE(name, lower);
+  appendLTE(name, upper);
+}
+
+void FileQuery::appendRangeInclusive(const std::string& name, const int lower, const int upper)
+{
+  appendGTE(name, lower);
+  appendLTE(name, upper);
+}
+
+bool FileQuery::matches(const FileMetadata& metadata) const
+{
+  const std::map<std::string, FileFieldValue>& fields = metadata.getFields();
+  for (const Condition& condition : conditions_)
+  {
+    std::map<std::string, FileFieldValue>::const_iterator it = fields.find(condition.field_);
+    if (it == fields.end())
+      return false;
+    // ordering comparisons are only defined between numbers
+    if (condition.op_ != EQ &&
+        (it->second.type_ == FileFieldValue::STRING || condition.value_.type_ == FileFieldValue::STRING))
+      return false;
+    const int c = it->second.compare(condition.value_);
+    switch (condition.op_)
+    {
+      case EQ:
+        if (c != 0)
+          return false;
+        break;
+      case LT:
+        if (c >= 0)
+          return false;
+        break;
+      case LTE:
+        if (c > 0)
+          return false;
+        break;
+      case GT:
+        if (c <= 0)
+          return false;
+        break;
+      case GTE:
+        if (c < 0)
+          return false;
+        break;
+    }
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// In-memory database with its journal file
+
+struct FileRecord
+{
+  uint64_t id_;
+  FileMetadata::ConstPtr metadata_;
+  std::shared_ptr<const std::string> message_;
+};
+
+/** \brief The content of all databases stored in one file. All methods are thread safe. */
+class FileDatabase
+{
+public:
+  explicit FileDatabase(const std::string& path) : path_(path), lock_fd_(-1), next_id_(0), stale_entries_(0)
+  {
+  }
+
+  ~FileDatabase()
+  {
+    journal_.close();
+    if (lock_fd_ >= 0)
+      ::close(lock_fd_);  // releases the lock
+  }
+
+  /** \brief Lock the file, replay the journal (if it exists) and open it for appending */
+  bool open()
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    if (!lockFile())
+      return false;
+    if (boost::filesystem::exists(path_) && !load())
+      return false;
+
+    if (stale_entries_ > countRecords())
+      compact();
+
+    if (!boost::filesystem::exists(path_))
+    {
+      journal_.open(path_.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      journal_.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    }
+    else
+      journal_.open(path_.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    journal_.flush();
+    if (!journal_)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Unable to open database file '%s' for writing", path_.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  bool initializeCollection(const std::string& db, const std::string& coll, const std::string& datatype,
+                            const std::string& md5)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    Collection* collection = findCollection(db, coll);
+    if (collection)
+    {
+      if (collection->md5_ != md5)
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Collection '%s.%s' stores messages of type '%s' with a different checksum than '%s'",
+                        db.c_str(), coll.c_str(), collection->datatype_.c_str(), datatype.c_str());
+        return false;
+      }
+      return true;
+    }
+    createCollection(db, coll, datatype, md5);
+    return true;
+  }
+
+  void insert(const std::string& db, const std::string& coll, const std::string& datatype, const std::string& md5,
+              const std::shared_ptr<const std::string>& message, const FileMetadata::ConstPtr& metadata)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    Collection* collection = findCollection(db, coll);
+    if (!collection)
+      collection = &createCollection(db, coll, datatype, md5);
+
+    FileRecord record;
+    record.id_ = next_id_++;
+    record.metadata_ = metadata;
+    record.message_ = message;
+    addRecord(*collection, record);
+
+    writePod<uint8_t>(journal_, OP_INSERT);
+    writeString(journal_, db);
+    writeString(journal_, coll);
+    writePod(journal_, record.id_);
+    writeMetadata(journal_, *metadata);
+    writeString(journal_, *message);
+    flushJournal();
+  }
+
+  std::vector<FileRecord> query(const std::string& db, const std::string& coll, const FileQuery& query,
+                                const std::string& sort_by, bool ascending) const
+  {
+    std::vector<FileRecord> result;
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      const Collection* collection = findCollection(db, coll);
+      if (!collection)
+        return result;
+      forEachMatch(*collection, query, [&result](const FileRecord& record) { result.push_back(record); });
+    }
+
+    if (!sort_by.empty())
+      std::stable_sort(result.begin(), result.end(), [&sort_by, ascending](const FileRecord& a, const FileRecord& b) {
+        const std::map<std::string, FileFieldValue>& fa = a.metadata_->getFields();
+        const std::map<std::string, FileFieldValue>& fb = b.metadata_->getFields();
+        std::map<std::string, FileFieldValue>::const_iterator ia = fa.find(sort_by);
+        std::map<std::string, FileFieldValue>::const_iterator ib = fb.find(sort_by);
+        // records without the field sort first
+        int c;
+        if (ia == fa.end() || ib == fb.end())
+          c = (ia == fa.end() ? 0 : 1) - (ib == fb.end() ? 0 : 1);
+        else
+          c = ia->second.compare(ib->second);
+        return ascending ? c < 0 : c > 0;
+      });
+    return result;
+  }
+
+  unsigned remove(const std::string& db, const std::string& coll, const FileQuery& query)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    Collection* collection = findCollection(db, coll);
+    if (!collection)
+      return 0;
+    std::vector<uint64_t> ids;
+    forEachMatch(*collection, query, [&ids](const FileRecord& record) { ids.push_back(record.id_); });
+    for (uint64_t id : ids)
+    {
+      removeRecord(*collection, id);
+      writePod<uint8_t>(journal_, OP_REMOVE);
+      writeString(journal_, db);
+      writeString(journal_, coll);
+      writePod(journal_, id);
+      stale_entries_ += 2;
+    }
+    flushJournal();
+    return ids.size();
+  }
+
+  void modify(const std::string& db, const std::string& coll, const FileQuery& query, const FileMetadata& changes)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    Collection* collection = findCollection(db, coll);
+    if (!collection)
+      return;
+    std::vector<FileRecord> records;
+    forEachMatch(*collection, query, [&records](const FileRecord& record) { records.push_back(record); });
+    for (FileRecord& record : records)
+    {
+      // metadata is copied on write so results handed out earlier are not affected
+      FileMetadata::Ptr metadata(new FileMetadata(*record.metadata_));
+      for (const std::pair<const std::string, FileFieldValue>& field : changes.getFields())
+        metadata->setField(field.first, field.second);
+      removeRecord(*collection, record.id_);
+      record.metadata_ = metadata;
+      addRecord(*collection, record);
+
+      writePod<uint8_t>(journal_, OP_MODIFY);
+      writeString(journal_, db);
+      writeString(journal_, coll);
+      writePod(journal_, record.id_);
+      writeMetadata(journal_, *metadata);
+      ++stale_entries_;
+    }
+    flushJournal();
+  }
+
+  unsigned count(const std::string& db, const std::string& coll) const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    const Collection* collection = findCollection(db, coll);
+    return collection ? collection->records_.size() : 0;
+  }
+
+  void drop(const std::string& db)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::map<std::string, std::map<std::string, Collection> >::iterator it = databases_.find(db);
+    if (it == databases_.end())
+      return;
+    for (const std::pair<const std::string, Collection>& collection : it->second)
+      stale_entries_ += collection.second.records_.size() + 1;
+    databases_.erase(it);
+    writePod<uint8_t>(journal_, OP_DROP);
+    writeString(journal_, db);
+    flushJournal();
+  }
+
+  std::string messageType(const std::string& db, const std::string& coll) const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    const Collection* collection = findCollection(db, coll);
+    return collection ? collection->datatype_ : std::string();
+  }
+
+private:
+  struct Collection
+  {
+    std::string datatype_;
+    std::string md5_;
+    std::map<uint64_t, FileRecord> records_;                         // ordered by insertion
+    std::unordered_map<std::string, std::set<uint64_t> > index_;  // string field/value -> record ids
+  };
+
+  Collection* findCollection(const std::string& db, const std::string& coll)
+  {
+    std::map<std::string, std::map<std::string, Collection> >::iterator it = databases_.find(db);
+    if (it == databases_.end())
+      return nullptr;
+    std::map<std::string, Collection>::iterator jt = it->second.find(coll);
+    return jt == it->second.end() ? nullptr : &jt->second;
+  }
+
+  const Collection* findCollection(const std::string& db, const std::string& coll) const
+  {
+    return const_cast<FileDatabase*>(this)->findCollection(db, coll);
+  }
+
+  Collection& createCollection(const std::string& db, const std::string& coll, const std::string& datatype,
+                               const std::string& md5, bool journal = true)
+  {
+    Collection& collection = databases_[db][coll];
+    collection.datatype_ = datatype;
+    collection.md5_ = md5;
+    if (journal)
+    {
+      writePod<uint8_t>(journal_, OP_COLLECTION);
+      writeString(journal_, db);
+      writeString(journal_, coll);
+      writeString(journal_, datatype);
+      writeString(journal_, md5);
+      flushJournal();
+    }
+    return collection;
+  }
+
+  void addRecord(Collection& collection, const FileRecord& record)
+  {
+    collection.records_[record.id_] = record;
+    for (const std::pair<const std::string, FileFieldValue>& field : record.metadata_->getFields())
+      if (field.second.type_ == FileFieldValue::STRING)
+        collection.index_[indexKey(field.first, field.second.string_)].insert(record.id_);
+  }
+
+  void removeRecord(Collection& collection, uint64_t id)
+  {
+    std::map<uint64_t, FileRecord>::iterator it = collection.records_.find(id);
+    if (it == collection.records_.end())
+      return;
+    for (const std::pair<const std::string, FileFieldValue>& field : it->second.metadata_->getFields())
+      if (field.second.type_ == FileFieldValue::STRING)
+      {
+        std::unordered_map<std::string, std::set<uint64_t> >::iterator jt =
+            collection.index_.find(indexKey(field.first, field.second.string_));
+        if (jt != collection.index_.end())
+        {
+          jt->second.erase(id);
+          if (jt->second.empty())
+            collection.index_.erase(jt);
+        }
+      }
+    collection.records_.erase(it);
+  }
+
+  /** \brief Call \e fn for every record matching \e query, in insertion order. Equality conditions on string fields
+   * restrict the candidates through the index; all other conditions are checked on the candidates. */
+  template <typename Fn>
+  void forEachMatch(const Collection& collection, const FileQuery& query, const Fn& fn) const
+  {
+    const std::set<uint64_t>* candidates = nullptr;
+    for (const FileQuery::Condition& condition : query.getConditions())
+      if (condition.op_ == FileQuery::EQ && condition.value_.type_ == FileFieldValue::STRING)
+      {
+        std::unordered_map<std::string, std::set<uint64_t> >::const_iterator it =
+            collection.index_.find(indexKey(condition.field_, condition.value_.string_));
+        if (it == collection.index_.end())
+          return;
+        if (!candidates || it->second.size() < candidates->size())
+          candidates = &it->second;
+      }
+
+    if (candidates)
+    {
+      for (uint64_t id : *candidates)
+      {
+        const FileRecord& record = collection.records_.at(id);
+        if (query.matches(*record.metadata_))
+          fn(record);
+      }
+    }
+    else
+      for (const std::pair<const uint64_t, FileRecord>& record : collection.records_)
+        if (query.matches(*record.second.metadata_))
+          fn(record.second);
+  }
+
+  std::size_t countRecords() const
+  {
+    std::size_t count = 0;
+    for (const std::pair<const std::string, std::map<std::string, Collection> >& db : databases_)
+      for (const std::pair<const std::string, Collection>& collection : db.second)
+        count += collection.second.records_.size();
+    return count;
+  }
+
+  /** \brief Take an advisory lock so no other process uses the same file. The journal itself is replaced when it is
+   * compacted, so the lock is held on a separate file next to it. */
+  bool lockFile()
+  {
+    const std::string lock_path = path_ + ".lock";
+    lock_fd_ = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd_ < 0)
+    {
+      ROS_ERROR_NAMED(LOGNAME, "Unable to open lock file '%s': %s", lock_path.c_str(), std::strerror(errno));
+      return false;
+    }
+    if (::flock(lock_fd_, LOCK_EX | LOCK_NB) != 0)
+    {
+      if (errno == EWOULDBLOCK)
+        ROS_ERROR_NAMED(LOGNAME, "Database file '%s' is already in use by another process (locked through '%s')",
+                        path_.c_str(), lock_path.c_str());
+      else
+        ROS_ERROR_NAMED(LOGNAME, "Unable to lock database file '%s': %s", path_.c_str(), std::strerror(errno));
+      ::close(lock_fd_);
+      lock_fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  void flushJournal()
+  {
+    journal_.flush();
+    if (!journal_)
+      ROS_ERROR_NAMED(LOGNAME, "Failed writing to database file '%s'", path_.c_str());
+  }
+
+  bool load()
+  {
+    std::ifstream in(path_.c_str(), std::ios::in | std::ios::binary);
+    char magic[sizeof(FILE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), FILE_MAGIC))
+    {
+      ROS_ERROR_NAMED(LOGNAME, "File '%s' is not a MoveIt! warehouse database", path_.c_str());
+      return false;
+    }
+
+    uint8_t op;
+    bool truncated = false;
+    while (readPod(in, op))
+    {
+      std::string db, coll;
+      if (op != OP_DROP && !(readString(in, db) && readString(in, coll)))
+      {
+        truncated = true;
+        break;
+      }
+
+      bool ok = true;
+      switch (op)
+      {
+        case OP_COLLECTION:
+        {
+          std::string datatype, md5;
+          ok = readString(in, datatype) && readString(in, md5);
+          if (ok && !findCollection(db, coll))
+            createCollection(db, coll, datatype, md5, false);
+          break;
+        }
+        case OP_INSERT:
+        case OP_MODIFY:
+        {
+          uint64_t id;
+          FileMetadata::Ptr metadata(new FileMetadata());
+          ok = readPod(in, id) && readMetadata(in, *metadata);
+          std::shared_ptr<std::string> message;
+          if (ok && op == OP_INSERT)
+          {
+            message = std::make_shared<std::string>();
+            ok = readString(in, *message);
+          }
+          Collection* collection = ok ? findCollection(db, coll) : nullptr;
+          if (!collection)
+            break;
+          FileRecord record;
+          record.id_ = id;
+          record.metadata_ = metadata;
+          if (op == OP_MODIFY)
+          {
+            std::map<uint64_t, FileRecord>::const_iterator it = collection->records_.find(id);
+            if (it == collection->records_.end())
+              break;
+            record.message_ = it->second.message_;
+            removeRecord(*collection, id);
+            ++stale_entries_;
+          }
+          else
+            record.message_ = message;
+          addRecord(*collection, record);
+          next_id_ = std::max(next_id_, id + 1);
+          break;
+        }
+        case OP_REMOVE:
+        {
+          uint64_t id;
+          ok = readPod(in, id);
+          Collection* collection = ok ? findCollection(db, coll) : nullptr;
+          if (collection)
+            removeRecord(*collection, id);
+          stale_entries_ += 2;
+          break;
+        }
+        case OP_DROP:
+        {
+          ok = readString(in, db);
+          std::map<std::string, std::map<std::string, Collection> >::iterator it = databases_.find(db);
+          if (ok && it != databases_.end())
+          {
+            for (const std::pair<const std::string, Collection>& collection : it->second)
+              stale_entries_ += collection.second.records_.size() + 1;
+            databases_.erase(it);
+          }
+          break;
+        }
+        default:
+          ok = false;
+      }
+      if (!ok)
+      {
+        truncated = true;
+        break;
+      }
+    }
+
+    if (truncated)
+    {
+      // an interrupted write leaves a partial entry at the end; rewriting the file drops it
+      ROS_WARN_NAMED(LOGNAME, "Database file '%s' ends with an incomplete entry, which is discarded", path_.c_str());
+      compact();
+    }
+    ROS_DEBUG_NAMED(LOGNAME, "Loaded %zu messages from '%s'", countRecords(), path_.c_str());
+    return true;
+  }
+
+  /** \brief Rewrite the journal so it contains only the live collections and records */
+  void compact()
+  {
+    const std::string tmp_path = path_ + ".tmp";
+    {
+      std::ofstream out(tmp_path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+      out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+      for (const std::pair<const std::string, std::map<std::string, Collection> >& db : databases_)
+        for (const std::pair<const std::string, Collection>& collection : db.second)
+        {
+          writePod<uint8_t>(out, OP_COLLECTION);
+          writeString(out, db.first);
+          writeString(out, collection.first);
+          writeString(out, collection.second.datatype_);
+          writeString(out, collection.second.md5_);
+          for (const std::pair<const uint64_t, FileRecord>& record : collection.second.records_)
+          {
+            writePod<uint8_t>(out, OP_INSERT);
+            writeString(out, db.first);
+            writeString(out, collection.first);
+            writePod(out, record.first);
+            writeMetadata(out, *record.second.metadata_);
+            writeString(out, *record.second.message_);
+          }
+        }
+      out.flush();
+      if (!out)
+      {
+        ROS_ERROR_NAMED(LOGNAME, "Unable to compact database file '%s'", path_.c_str());
+        return;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path_.c_str()) != 0)
+      ROS_ERROR_NAMED(LOGNAME, "Unable to replace database file '%s'", path_.c_str());
+    else
+      stale_entries_ = 0;
+  }
+
+  const std::string path_;
+  mutable boost::mutex lock_;
+  int lock_fd_;
+  std::ofstream journal_;
+  std::map<std::string, std::map<std::string, Collection> > databases_;
+  uint64_t next_id_;
+  std::size_t stale_entries_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// warehouse_ros helpers
+
+namespace
+{
+class FileResultIterator : public warehouse_ros::ResultIteratorHelper
+{
+public:
+  FileResultIterator(std::vector<FileRecord>&& records, const FileQuery& query)
+    : records_(std::move(records)), query_(new FileQuery(query)), current_(0)
+  {
+  }
+
+  bool next() override
+  {
+    ++current_;
+    return hasData();
+  }
+
+  bool hasData() const override
+  {
+    return current_ < records_.size();
+  }
+
+  warehouse_ros::Metadata::ConstPtr metadata() const override
+  {
+    return records_[current_].metadata_;
+  }
+
+  std::string message() const override
+  {
+    return *records_[current_].message_;
+  }
+
+  warehouse_ros::Query::Ptr query() const override
+  {
+    // a copy, so callers extending the query do not change the one this iterator was created from
+    return warehouse_ros::Query::Ptr(new FileQuery(*query_));
+  }
+
+private:
+  std::vector<FileRecord> records_;
+  FileQuery::ConstPtr query_;
+  std::size_t current_;
+};
+
+/** \brief Get the database stored in the file \e path, opening it if no connection of this process uses it yet.
+ * The file lock only keeps other processes out, so all connections of this process to one file have to share the
+ * same FileDatabase. Returns nullptr if the file cannot be opened. */
+std::shared_ptr<FileDatabase> openDatabase(const std::string& path)
+{
+  // recursive, as the last reference to a database may be dropped while the registry is locked
+  static boost::recursive_mutex registry_lock;
+  static std::map<std::string, std::weak_ptr<FileDatabase> > registry;
+
+  boost::system::error_code ec;
+  boost::filesystem::path file(path);
+  boost::filesystem::path parent = boost::filesystem::canonical(boost::filesystem::absolute(file).parent_path(), ec);
+  const std::string key = ec ? boost::filesystem::absolute(file).string() : (parent / file.filename()).string();
+
+  boost::recursive_mutex::scoped_lock slock(registry_lock);
+  std::shared_ptr<FileDatabase> database = registry[key].lock();
+  if (database)
+    return database;
+
+  // a database is destroyed, and its file unlocked, under the registry lock, so that the file is never opened again
+  // while the previous FileDatabase still holds the lock
+  database.reset(new FileDatabase(path), [](FileDatabase* db) {
+    boost::recursive_mutex::scoped_lock slock(registry_lock);
+    delete db;
+  });
+  if (!database->open())
+    return std::shared_ptr<FileDatabase>();
+  registry[key] = database;
+  return database;
+}
+
+class FileMessageCollection : public warehouse_ros::MessageCollectionHelper
+{
+public:
+  FileMessageCollection(const std::shared_ptr<FileDatabase>& database, const std::string& db,
+                        const std::string& coll)
+    : database_(database), db_(db), coll_(coll)
+  {
+  }
+
+  bool initialize(const std::string& datatype, const std::string& md5) override
+  {
+    datatype_ = datatype;
+    md5_ = md5;
+    return database_->initializeCollection(db_, coll_, datatype, md5);
+  }
+
+  void insert(char* msg, size_t msg_size, warehouse_ros::Metadata::ConstPtr metadata) override
+  {
+    FileMetadata::ConstPtr file_metadata = boost::dynamic_pointer_cast<const FileMetadata>(metadata);
+    FileMetadata::Ptr stored(file_metadata ? new FileMetadata(*file_metadata) : new FileMetadata());
+    if (!stored->lookupField("creation_time"))
+      stored->append("creation_time", ros::WallTime::now().toSec());
+    database_->insert(db_, coll_, datatype_, md5_, std::make_shared<const std::string>(msg, msg_size), stored);
+  }
+
+  warehouse_ros::ResultIteratorHelper::Ptr query(warehouse_ros::Query::ConstPtr query, const std::string& sort_by,
+                                                 bool ascending) const override
+  {
+    const FileQuery& file_query = toFileQuery(query);
+    return warehouse_ros::ResultIteratorHelper::Ptr(
+        new FileResultIterator(database_->query(db_, coll_, file_query, sort_by, ascending), file_query));
+  }
+
+  unsigned removeMessages(warehouse_ros::Query::ConstPtr query) override
+  {
+    return database_->remove(db_, coll_, toFileQuery(query));
+  }
+
+  void modifyMetadata(warehouse_ros::Query::ConstPtr q, warehouse_ros::Metadata::ConstPtr m) override
+  {
+    FileMetadata::ConstPtr changes = boost::dynamic_pointer_cast<const FileMetadata>(m);
+    if (changes)
+      database_->modify(db_, coll_, toFileQuery(q), *changes);
+  }
+
+  unsigned count() override
+  {
+    return database_->count(db_, coll_);
+  }
+
+  warehouse_ros::Query::Ptr createQuery() const override
+  {
+    return warehouse_ros::Query::Ptr(new FileQuery());
+  }
+
+  warehouse_ros::Metadata::Ptr createMetadata() const override
+  {
+    return warehouse_ros::Metadata::Ptr(new FileMetadata());
+  }
+
+  std::string collectionName() const override
+  {
+    return coll_;
+  }
+
+private:
+  static const FileQuery& toFileQuery(const warehouse_ros::Query::ConstPtr& query)
+  {
+    // an empty query matches everything, so a query of another backend must not be treated as one
+    const FileQuery* file_query = dynamic_cast<const FileQuery*>(query.get());
+    if (!file_query)
+      throw warehouse_ros::WarehouseRosException("Query was not created by the file database backend");
+    return *file_query;
+  }
+
+  std::shared_ptr<FileDatabase> database_;
+  std::string db_;
+  std::string coll_;
+  std::string datatype_;
+  std::string md5_;
+};
+}  // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Connection
+
+FileDatabaseConnection::FileDatabaseConnection() : path_(defaultDatabasePath())
+{
+}
+
+FileDatabaseConnection::~FileDatabaseConnection() = default;
+
+bool FileDatabaseConnection::setParams(const std::string& host, unsigned port, float timeout)
+{
+  path_ = (host.empty() || host == "localhost") ? defaultDatabasePath() : host;
+  return true;
+}
+
+bool FileDatabaseConnection::setTimeout(float timeout)
+{
+  return true;
+}
+
+bool FileDatabaseConnection::connect()
+{
+  if (database_)
+    return true;
+  boost::system::error_code ec;
+  boost::filesystem::path parent = boost::filesystem::path(path_).parent_path();
+  if (!parent.empty())
+    boost::filesystem::create_directories(parent, ec);
+
+  std::shared_ptr<FileDatabase> database = openDatabase(path_);
+  if (!database)
+    return false;
+  database_ = database;
+  ROS_INFO_NAMED(LOGNAME, "Using warehouse database file '%s'", path_.c_str());
+  return true;
+}
+
+bool FileDatabaseConnection::isConnected()
+{
+  return static_cast<bool>(database_);
+}
+
+void FileDatabaseConnection::dropDatabase(const std::string& db_name)
+{
+  if (!database_)
+    throw warehouse_ros::DbConnectException("Not connected to the database");
+  database_->drop(db_name);
+}
+
+std::string FileDatabaseConnection::messageType(const std::string& db_name, const std::string& collection_name)
+{
+  if (!database_)
+    throw warehouse_ros::DbConnectException("Not connected to the database");
+  return database_->messageType(db_name, collection_name);
+}
+
+warehouse_ros::MessageCollectionHelper::Ptr
+FileDatabaseConnection::openCollectionHelper(const std::string& db_name, const std::string& collection_name)
+{
+  if (!database_)
+    throw warehouse_ros::DbConnectException("Not connected to the database");
+  return warehouse_ros::MessageCollectionHelper::Ptr(new FileMessageCollection(database_, db_name, collection_name));
+}
+}  // namespace moveit_warehouse
+
+PLUGINLIB_EXPORT_CLASS(moveit_warehouse::FileDatabaseConnection, warehouse_ros::DatabaseConnection)
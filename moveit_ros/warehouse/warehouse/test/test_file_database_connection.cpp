@@ -0,0 +1,349 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, agent.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/warehouse/file_database_connection.h>
+#include <warehouse_ros/exceptions.h>
+#include <geometry_msgs/Pose.h>
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+using warehouse_ros::Metadata;
+using warehouse_ros::Query;
+typedef warehouse_ros::MessageCollection<geometry_msgs::Pose> PoseCollection;
+typedef warehouse_ros::MessageWithMetadata<geometry_msgs::Pose>::ConstPtr PoseWithMetadata;
+
+class FileDatabaseConnectionTest : public testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    directory_ = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("moveit_warehouse_%%%%%%%%");
+    boost::filesystem::create_directories(directory_);
+    path_ = (directory_ / "test.db").string();
+  }
+
+  void TearDown() override
+  {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(directory_, ec);
+  }
+
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> connect()
+  {
+    std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn(new moveit_warehouse::FileDatabaseConnection());
+    conn->setParams(path_, 0, 0.0);
+    if (!conn->connect())
+      conn.reset();
+    return conn;
+  }
+
+  static void insertPose(PoseCollection& collection, const std::string& name, int order, double x)
+  {
+    geometry_msgs::Pose pose;
+    pose.position.x = x;
+    pose.orientation.w = 1.0;
+    Metadata::Ptr metadata = collection.createMetadata();
+    metadata->append("name", name);
+    metadata->append("order", order);
+    collection.insert(pose, metadata);
+  }
+
+  static std::vector<PoseWithMetadata> findByName(PoseCollection& collection, const std::string& name)
+  {
+    Query::Ptr q = collection.createQuery();
+    q->append("name", name);
+    return collection.queryList(q, false);
+  }
+
+  uintmax_t fileSize() const
+  {
+    return boost::filesystem::file_size(path_);
+  }
+
+  boost::filesystem::path directory_;
+  std::string path_;
+};
+
+TEST_F(FileDatabaseConnectionTest, RoundTrip)
+{
+  {
+    std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+    ASSERT_TRUE(conn);
+    PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+    insertPose(*collection, "a", 1, 1.5);
+    insertPose(*collection, "b", 2, -2.5);
+    EXPECT_EQ(collection->count(), 2u);
+  }
+
+  // everything is read back from the journal
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  EXPECT_EQ(collection->count(), 2u);
+  EXPECT_EQ(conn->messageType("db", "poses"), ros::message_traits::DataType<geometry_msgs::Pose>::value());
+
+  std::vector<PoseWithMetadata> poses = findByName(*collection, "b");
+  ASSERT_EQ(poses.size(), 1u);
+  EXPECT_EQ(poses[0]->position.x, -2.5);
+  EXPECT_EQ(poses[0]->orientation.w, 1.0);
+  EXPECT_EQ(poses[0]->lookupString("name"), "b");
+  EXPECT_EQ(poses[0]->lookupInt("order"), 2);
+  EXPECT_TRUE(poses[0]->lookupField("creation_time"));
+}
+
+TEST_F(FileDatabaseConnectionTest, Queries)
+{
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  for (int i = 0; i < 10; ++i)
+    insertPose(*collection, i % 2 ? "odd" : "even", i, i);
+
+  // equality on a string field goes through the index, combined with a range on another field
+  Query::Ptr q = collection->createQuery();
+  q->append("name", std::string("even"));
+  q->appendRangeInclusive("order", 2, 6);
+  std::vector<PoseWithMetadata> poses = collection->queryList(q, false, "order", false);
+  ASSERT_EQ(poses.size(), 3u);
+  EXPECT_EQ(poses[0]->lookupInt("order"), 6);
+  EXPECT_EQ(poses[1]->lookupInt("order"), 4);
+  EXPECT_EQ(poses[2]->lookupInt("order"), 2);
+
+  // a range alone scans the collection
+  q = collection->createQuery();
+  q->appendLT("order", 3);
+  EXPECT_EQ(collection->queryList(q, true).size(), 3u);
+
+  // unknown values and missing fields match nothing
+  EXPECT_TRUE(findByName(*collection, "none").empty());
+  q = collection->createQuery();
+  q->append("missing", 1);
+  EXPECT_TRUE(collection->queryList(q, true).empty());
+
+  // metadata changes are reflected in the index
+  q = collection->createQuery();
+  q->append("order", 3);
+  Metadata::Ptr m = collection->createMetadata();
+  m->append("name", std::string("renamed"));
+  collection->modifyMetadata(q, m);
+  EXPECT_EQ(findByName(*collection, "odd").size(), 4u);
+  ASSERT_EQ(findByName(*collection, "renamed").size(), 1u);
+  EXPECT_EQ(findByName(*collection, "renamed")[0]->position.x, 3.0);
+
+  q = collection->createQuery();
+  q->append("name", std::string("even"));
+  EXPECT_EQ(collection->removeMessages(q), 5u);
+  EXPECT_EQ(collection->count(), 5u);
+  EXPECT_TRUE(findByName(*collection, "even").empty());
+}
+
+TEST_F(FileDatabaseConnectionTest, ReopenCompactsJournal)
+{
+  uintmax_t journal_size;
+  {
+    std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+    ASSERT_TRUE(conn);
+    PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+    for (int i = 0; i < 10; ++i)
+      insertPose(*collection, "pose" + std::to_string(i), i, i);
+    Query::Ptr q = collection->createQuery();
+    q->appendGTE("order", 2);
+    EXPECT_EQ(collection->removeMessages(q), 8u);
+    journal_size = fileSize();
+  }
+
+  // most of the journal is stale, so it is rewritten on reopen
+  {
+    std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+    ASSERT_TRUE(conn);
+    EXPECT_LT(fileSize(), journal_size);
+    journal_size = fileSize();
+    PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+    EXPECT_EQ(collection->count(), 2u);
+    ASSERT_EQ(findByName(*collection, "pose1").size(), 1u);
+  }
+
+  // a partial entry left by an interrupted write is dropped
+  {
+    std::ofstream out(path_.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    const char partial[] = { 2, 5, 0 };
+    out.write(partial, sizeof(partial));
+  }
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  EXPECT_EQ(fileSize(), journal_size);
+  PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  EXPECT_EQ(collection->count(), 2u);
+
+  // ids keep increasing after the reload, so new messages do not replace old ones
+  insertPose(*collection, "pose10", 10, 10);
+  EXPECT_EQ(collection->count(), 3u);
+  EXPECT_EQ(findByName(*collection, "pose0").size(), 1u);
+}
+
+TEST_F(FileDatabaseConnectionTest, DropDatabase)
+{
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  insertPose(*collection, "a", 1, 1.0);
+  conn->dropDatabase("db");
+  EXPECT_EQ(collection->count(), 0u);
+  EXPECT_TRUE(conn->messageType("db", "poses").empty());
+}
+
+TEST_F(FileDatabaseConnectionTest, ConnectionsShareDatabase)
+{
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn1 = connect();
+  ASSERT_TRUE(conn1);
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn2 = connect();
+  ASSERT_TRUE(conn2);
+
+  PoseCollection::Ptr collection1 = conn1->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  PoseCollection::Ptr collection2 = conn2->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  insertPose(*collection1, "a", 1, 1.0);
+  EXPECT_EQ(findByName(*collection2, "a").size(), 1u);
+
+  // the database stays open as long as any connection uses it
+  conn1.reset();
+  collection1.reset();
+  insertPose(*collection2, "b", 2, 2.0);
+  conn2.reset();
+  collection2.reset();
+
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  EXPECT_EQ(conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses")->count(), 2u);
+}
+
+TEST_F(FileDatabaseConnectionTest, FileIsLocked)
+{
+  // a lock taken through a separate open file description conflicts like the lock of another process
+  const std::string lock_path = path_ + ".lock";
+  {
+    std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+    ASSERT_TRUE(conn);
+    int fd = ::open(lock_path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    EXPECT_NE(::flock(fd, LOCK_EX | LOCK_NB), 0);
+    ::close(fd);
+  }
+
+  int fd = ::open(lock_path.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(::flock(fd, LOCK_EX | LOCK_NB), 0);
+  EXPECT_FALSE(connect());
+
+  // the lock is released with the connection
+  ::close(fd);
+  EXPECT_TRUE(connect());
+}
+
+// a query of another warehouse backend
+class ForeignQuery : public warehouse_ros::Query
+{
+public:
+  void appendLT(const std::string& name, const double val) override
+  {
+  }
+  void appendLTE(const std::string& name, const double val) override
+  {
+  }
+  void appendGT(const std::string& name, const double val) override
+  {
+  }
+  void appendGTE(const std::string& name, const double val) override
+  {
+  }
+  void appendLT(const std::string& name, const int val) override
+  {
+  }
+  void appendLTE(const std::string& name, const int val) override
+  {
+  }
+  void appendGT(const std::string& name, const int val) override
+  {
+  }
+  void appendGTE(const std::string& name, const int val) override
+  {
+  }
+  void appendRange(const std::string& name, const double lower, const double upper) override
+  {
+  }
+  void appendRange(const std::string& name, const int lower, const int upper) override
+  {
+  }
+  void appendRangeInclusive(const std::string& name, const double lower, const double upper) override
+  {
+  }
+  void appendRangeInclusive(const std::string& name, const int lower, const int upper) override
+  {
+  }
+
+protected:
+  void appendString(const std::string& name, const std::string& val) override
+  {
+  }
+  void appendDouble(const std::string& name, const double val) override
+  {
+  }
+  void appendInt(const std::string& name, const int val) override
+  {
+  }
+  void appendBool(const std::string& name, const bool val) override
+  {
+  }
+};
+
+TEST_F(FileDatabaseConnectionTest, ForeignQueryIsRejected)
+{
+  std::unique_ptr<moveit_warehouse::FileDatabaseConnection> conn = connect();
+  ASSERT_TRUE(conn);
+  PoseCollection::Ptr collection = conn->openCollectionPtr<geometry_msgs::Pose>("db", "poses");
+  insertPose(*collection, "a", 1, 1.0);
+
+  // treating the query as empty would remove every message
+  EXPECT_THROW(collection->removeMessages(Query::Ptr(new ForeignQuery())), warehouse_ros::WarehouseRosException);
+  EXPECT_EQ(collection->count(), 1u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}